@@ -1,6 +1,21 @@
 #ifndef AVLTREE_H_
 #define AVLTREE_H_
+#include <new>
+
+/*
+ * AvlTree reports errors with exceptions unless it is compiled with
+ * exceptions disabled (-fno-exceptions). In that case the throwing calls
+ * abort the program instead, and the try* variants (tryInsert, tryRemove,
+ * tryFind, Iterator::get) should be used - they report errors through their
+ * return value in both build modes.
+ */
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
 #include "exception.h"
+#define AVL_TREE_THROW(exception) throw exception
+#else
+#include <cstdlib>
+#define AVL_TREE_THROW(exception) std::abort()
+#endif
 
 
 template<class T> class Node;
@@ -11,13 +26,16 @@ template<class T>
 class Node {
 	Node<T> *left;
 	Node<T> *right;
+	Node<T> *parent;
+	int height;
 	T data;
 	/**
-	 * Node c'tor. allocates new Node and a copy of the data object.
+	 * Node c'tor. constructs a new leaf Node holding a copy of the data object.
+	 * the memory of the node is taken from the reserve of the tree.
 	 *
 	 * @param object - T object to hold in this node
 	 * @param left - a pointer to the left son in the tree.
-	 * @param previous - a pointer to the right son in the tree.
+	 * @param right - a pointer to the right son in the tree.
 	 * @return new Node
 	 */
 	Node(const T& object, Node<T> *left, Node<T> *right);
@@ -35,6 +53,16 @@ public:
 	void swapNodes(Node<T> *node);
 };
 
+/**
+ * NodeSlot - raw storage for a single Node. a free slot is used as a link in
+ * the reserve's free list, a taken slot holds a constructed Node.
+ */
+template<class T>
+union NodeSlot {
+	NodeSlot<T> *next;
+	alignas(Node<T>) unsigned char storage[sizeof(Node<T>)];
+};
+
 template<class T>
 class Iterator {
 	Node<T> *node;
@@ -48,7 +76,7 @@ class Iterator {
 	 * @param avlTree - a pointer to the avlTree the iterator belongs to.
 	 * @return new Node
 	 */
-	Iterator(Node<T> *node, List<T> *avlTree = nullptr);
+	Iterator(Node<T> *node, AvlTree<T> *avlTree = nullptr);
 	friend class AvlTree<T> ;
 
 public:
@@ -59,6 +87,16 @@ public:
 	//default operator= for Iterator
 	Iterator<T>& operator=(const Iterator<T>& iter) = default;
 
+	/**
+	 * prefix ++iterator - proceed the iterator to the next element in the
+	 * 					   tree, using inorder.
+	 *
+	 * @throw - IllegealOperationException - if current iterator points to the tree's end
+	 *
+	 * @return Iterator<T>& - the advanced iterator
+	 */
+	Iterator<T>& operator++();
+
 	/**
 	 * postfix iterator++ - call's when iterator++ used
 	 * 						the operator proceed the iterator to next element in the tree,
@@ -70,12 +108,23 @@ public:
 	 */
 	Iterator<T> operator++(int);
 
+	/**
+	 * prefix --iterator - move the iterator to the previous element in the
+	 * 					   tree. moving back from the first element reaches the
+	 * 					   tree's end.
+	 *
+	 * @throw - IllegealOperationException - if current iterator points to the tree's end
+	 *
+	 * @return Iterator<T>& - the moved iterator
+	 */
+	Iterator<T>& operator--();
+
 	/**
 	 * postfix iterator-- - call's when iterator-- used
 	 * 						the operator proceed the iterator to previous element in the tree,
 	 * 						but return's the previous one.
 	 *
-	 * @throw - IllegealOperationException - if current iterator points to the tree's root.
+	 * @throw - IllegealOperationException - if current iterator points to the tree's end
 	 *
 	 * @return Iterator<T> - an iterator to the same element in the tree
 	 */
@@ -88,6 +137,13 @@ public:
 	 * @return - T& - a reference to the data stored in the current node.
 	 */
 	T& operator*() const;
+	/**
+	 * get - the non throwing version of operator*.
+	 *
+	 * @return - T* - a pointer to the data stored in the current node, or
+	 * 			nullptr if the iterator points to tree's end.
+	 */
+	T* get() const;
 	/**
 	 * operator== - compares two iterators.
 	 * @param const Iterator<T>& iter - an iterator to be compared to.
@@ -104,30 +160,67 @@ public:
 	bool operator!=(const Iterator<T>& iter) const;
 };
 
+/**
+ * AvlTree - a balanced search tree of T objects, ordered by T's operator<.
+ *
+ * Nodes are never allocated one by one: the tree keeps a reserve of node
+ * slots, taken by insert and given back by remove. Once the reserve is large
+ * enough (see reserve) inserting and removing never allocate memory, so a
+ * caller that updates several trees can reserve in all of them first and
+ * then perform the inserts knowing none of them can fail.
+ */
 template<class T>
 class AvlTree {
+	static const int MIN_BLOCK_SIZE = 16;
+
 	Node<T> *root;
+	Node<T> *firstNode;
+	Node<T> *lastNode;
+	int treeSize;
+	NodeSlot<T> *freeSlots;
+	int freeCount;
+	NodeSlot<T> *blocks;
+
+	bool addBlock(int count);
+	Node<T>* allocateNode(const T& data);
+	void releaseNode(Node<T> *node);
+	void releaseSubtree(Node<T> *node);
+	Node<T>* copySubtree(const Node<T> *node, Node<T> *parent);
+	Node<T>* buildSubtree(const T* sorted, int low, int high, Node<T> *parent);
+	Node<T>* findNode(const T& data) const;
+	static int flattenSubtree(Node<T> *node, Node<T> **nodes, int index);
+	static Node<T>* linkSubtree(Node<T> **nodes, int low, int high,
+			Node<T> *parent);
+	void replaceChild(Node<T> *parent, Node<T> *oldChild, Node<T> *newChild);
+	Node<T>* rotateLeft(Node<T> *node);
+	Node<T>* rotateRight(Node<T> *node);
+	void rebalance(Node<T> *node);
+	void updateExtremes();
+	static int height(const Node<T> *node);
+	static void updateHeight(Node<T> *node);
+	static int balanceFactor(const Node<T> *node);
 public:
 	AvlTree();
-	
+
 	/**
 	 * copy c'tor of avlTree. copies all the elements in the tree.
 	 * @param avlTree - const reference to the tree we want to create a copy of.
 	 * @return
 	 */
-	AvlTree(AvlTree& avlTree);
+	AvlTree(const AvlTree& avlTree);
 	/**
-	 * avlTree destructor - used to clear the tree memory.
+	 * avlTree destructor - used to clear the tree memory, including the
+	 * reserved node slots.
 	 */
 	~AvlTree();
-	
+
 	AvlTree<T>& operator=(const AvlTree<T>& AvlTree);
-	
+
 	/**
-	 * begin - return an iterator to the root of the tree.
+	 * begin - return an iterator to the smallest element of the tree, in O(1).
 	 * in case the tree is empty, returns an iterator to the end of the tree.
 	 *
-	 * @return iterator to the root.
+	 * @return iterator to the smallest element.
 	 */
 	Iterator<T> begin();
 
@@ -139,30 +232,62 @@ public:
 	 *
 	 */
 	Iterator<T> end();
-	 
+
+	/**
+	 * last - return an iterator to the largest element of the tree, in O(1).
+	 * in case the tree is empty, returns an iterator to the end of the tree.
+	 *
+	 * @return iterator to the largest element.
+	 */
+	Iterator<T> last();
+
 	/**
 	 * insert - insert new element to the tree of type T. Inserts a copy
-	 * of the object. Keep the tree a search tree and legal AVL tree
+	 * of the object. Keep the tree a search tree and legal AVL tree.
+	 * the node is taken from the reserve, which grows only when empty.
 	 *
 	 * @param data - const reference to T object we want to insert.
+	 * @throw - std::bad_alloc - if the reserve is empty and growing it failed.
 	 *
 	 * @return void
 	 */
 	void insert(const T& data);
-	
+
+	/**
+	 * tryInsert - the non throwing version of insert.
+	 *
+	 * @param data - const reference to T object we want to insert.
+	 *
+	 * @return - true on success, false if the reserve is empty and growing
+	 * 			 it failed (the tree is left unchanged).
+	 */
+	bool tryInsert(const T& data);
+
 	/**
 	 * remove - remove an object from the tree, pointed by the iterator provided.
-						 keeping the tree a legal AVL tree.
+						 keeping the tree a legal AVL tree. the node is returned
+						 to the reserve for the next insert. the other elements
+						 are neither copied nor moved, so pointers and
+						 iterators to them stay valid.
 	 * @param - Iterator<T> - an iterator of the type of the tree, points
 	 * 						  the element to be removed
 	 * @throw - TreeExceptions::ElementNotFound -  in the following cases:
-	 * 							iterator points to the end of the list
-	 * 							iterator belongs to different list
-	 * 							list is empty
+	 * 							iterator points to the end of the tree
+	 * 							iterator belongs to different tree
+	 * 							tree is empty
 	 * @return void - no return value
 	 */
 	void remove(Iterator<T> iterator);
-	
+
+	/**
+	 * tryRemove - the non throwing version of remove.
+	 * @param - Iterator<T> - an iterator of the type of the tree, points
+	 * 						  the element to be removed
+	 * @return - true if the element was removed, false in the cases remove
+	 * 			 throws TreeExceptions::ElementNotFound.
+	 */
+	bool tryRemove(Iterator<T> iterator);
+
 	/**
 	 * find - find an object in the tree according to a specific condition
 	 * given in predicate.
@@ -173,13 +298,99 @@ public:
 	 */
 	template<class Predicate>
 	Iterator<T> find(const Predicate& predicate);
-	
+
+	/**
+	 * search - find an object equal to data (neither is smaller than the
+	 * other by operator<), in O(log n).
+	 *
+	 * @param data - const reference to the T object to look for.
+	 * @return - an iterator to the first element equal to data, or to the
+	 * end of the tree if there is none.
+	 */
+	Iterator<T> search(const T& data);
+
+	/**
+	 * tryFind - find an object in the tree according to a specific condition
+	 * given in predicate.
+	 *
+	 * @return - a pointer to the first object that meets the condition, or
+	 * nullptr if there is no such object in the tree.
+	 */
+	template<class Predicate>
+	T* tryFind(const Predicate& predicate);
+
+	/**
+	 * reserve - make sure at least count nodes can be inserted without
+	 * allocating memory. never throws, so it can be called before a
+	 * multi-tree update to acquire all the nodes the update needs.
+	 *
+	 * @param count - the number of inserts that must not allocate.
+	 * @return - true on success, false if the allocation failed (the tree
+	 * 			 is left unchanged).
+	 */
+	bool reserve(int count);
+
+	/**
+	 * buildFromSorted - replace the contents of the tree with copies of the
+	 * count objects in sorted, in O(count) time. the objects must already be
+	 * sorted by operator<, the result is a perfectly balanced tree.
+	 *
+	 * @param sorted - an array of count sorted objects.
+	 * @param count - the number of objects in sorted.
+	 * @return - true on success, false if the allocation failed (the tree
+	 * 			 is left unchanged).
+	 */
+	bool buildFromSorted(const T* sorted, int count);
+
+	/**
+	 * merge - move all the elements of another tree into this one, in
+	 * O(n + m) time. the nodes themselves are moved, not copied, together
+	 * with the reserve of the other tree, which is left empty.
+	 *
+	 * @param avlTree - the tree to merge into this one.
+	 * @return - true on success, false if the allocation of the temporary
+	 * 			 merge buffer failed (both trees are left unchanged).
+	 */
+	bool merge(AvlTree<T>& avlTree);
+
+	/**
+	 * clear - remove all the elements of the tree in O(n). the nodes go back
+	 * to the reserve.
+	 *
+	 * @return void
+	 */
+	void clear();
+
+	/**
+	 * removeSorted - remove one element equal to each of the count objects
+	 * in sorted. objects with no equal element in the tree are ignored.
+	 * few objects are removed one by one in O(count * log n), many objects
+	 * are removed in a single O(n + count) pass that flattens the tree,
+	 * filters it and relinks the remaining nodes into a balanced tree.
+	 *
+	 * @param sorted - an array of count objects, sorted by operator<.
+	 * @param count - the number of objects in sorted.
+	 * @return - the number of elements removed.
+	 */
+	int removeSorted(const T* sorted, int count);
+
+	/**
+	 * size - returns the number of elements in the tree.
+	 */
+	int size() const;
+
+	/**
+	 * reserved - returns the number of inserts that can be done without
+	 * allocating memory.
+	 */
+	int reserved() const;
+
 };
 
 /************** Node class Functions************/
 template<class T>
 Node<T>::Node(const T& object, Node<T> *left, Node<T> *right) :
-		left(left), right(right), data(object) {
+		left(left), right(right), parent(nullptr), height(1), data(object) {
 }
 
 template<class T>
@@ -194,16 +405,29 @@ void Node<T>::swapNodes(Node<T> *node) {
 /************** Iterator class Functions************/
 template<class T>
 Iterator<T>::Iterator(Node<T> *node, AvlTree<T> *avlTree) :
-		node(node), avlTree(avlTree) {
+		node(node), avlTreePtr(avlTree) {
 }
 
 template<class T>
-Iterator<T> Iterator<T>::operator--(int n) {
+Iterator<T>& Iterator<T>::operator++() {
 	if (this->node == nullptr) {
-		throw IllegealOperationException();
+		AVL_TREE_THROW(IllegealOperationException());
 	}
-	Node<T> *iterNode = this->node;
-	this->node = iterNode->next;
+	Node<T> *current = this->node;
+	if (current->right != nullptr) {
+		current = current->right;
+		while (current->left != nullptr) {
+			current = current->left;
+		}
+		this->node = current;
+		return *this;
+	}
+	Node<T> *parent = current->parent;
+	while (parent != nullptr && parent->right == current) {
+		current = parent;
+		parent = parent->parent;
+	}
+	this->node = parent;
 	return *this;
 }
 
@@ -214,18 +438,56 @@ Iterator<T> Iterator<T>::operator++(int n) {
 	return iter;
 }
 
+template<class T>
+Iterator<T>& Iterator<T>::operator--() {
+	if (this->node == nullptr) {
+		AVL_TREE_THROW(IllegealOperationException());
+	}
+	Node<T> *current = this->node;
+	if (current->left != nullptr) {
+		current = current->left;
+		while (current->right != nullptr) {
+			current = current->right;
+		}
+		this->node = current;
+		return *this;
+	}
+	Node<T> *parent = current->parent;
+	while (parent != nullptr && parent->left == current) {
+		current = parent;
+		parent = parent->parent;
+	}
+	this->node = parent;
+	return *this;
+}
+
+template<class T>
+Iterator<T> Iterator<T>::operator--(int n) {
+	Iterator<T> iter = Iterator(*this);
+	--*this; //call the prefix operator
+	return iter;
+}
+
 template<class T>
 T& Iterator<T>::operator*() const {
 	if (this->node == nullptr) {
-		throw TreeExceptions::ElementNotFound();
+		AVL_TREE_THROW(TreeExceptions::ElementNotFound());
 	}
 	Node<T> *iterNode = this->node;
 	return iterNode->data;
 }
 
+template<class T>
+T* Iterator<T>::get() const {
+	if (this->node == nullptr) {
+		return nullptr;
+	}
+	return &this->node->data;
+}
+
 template<class T>
 bool Iterator<T>::operator==(const Iterator<T>& iter) const {
-	return (this->node == iter.node) && (this->listPtr == iter.listPtr);
+	return (this->node == iter.node) && (this->avlTreePtr == iter.avlTreePtr);
 }
 
 template<class T>
@@ -235,51 +497,60 @@ bool Iterator<T>::operator!=(const Iterator<T>& iter) const {
 
 /**************End of Iterator class Functions************/
 
-/************** List class Functions************/
+/************** AvlTree class Functions************/
 template<class T>
 AvlTree<T>::AvlTree() :
-		root(nullptr) {
+		root(nullptr), firstNode(nullptr), lastNode(nullptr), treeSize(0),
+		freeSlots(nullptr), freeCount(0), blocks(nullptr) {
 }
 
 template<class T>
-AvlTree<T>::AvlTree(AvlTree<T>& avlTree) {
-	head = nullptr;
-	Iterator<T> newListIter = this->end();
-	Node<T> *nodeIter = list.head;
-	while (nodeIter != nullptr) {
-		this->insert(nodeIter->data, newListIter);
-		newListIter = this->end();
-		nodeIter = nodeIter->next;
+AvlTree<T>::AvlTree(const AvlTree<T>& avlTree) :
+		root(nullptr), firstNode(nullptr), lastNode(nullptr), treeSize(0),
+		freeSlots(nullptr), freeCount(0), blocks(nullptr) {
+	if (!this->reserve(avlTree.treeSize)) {
+		AVL_TREE_THROW(std::bad_alloc());
 	}
+	this->root = this->copySubtree(avlTree.root, nullptr);
+	this->treeSize = avlTree.treeSize;
+	this->updateExtremes();
 }
 
 template<class T>
 AvlTree<T>::~AvlTree() {
-	Iterator<T> iter = this->begin();
-	while (iter.node != nullptr) {
-		this->remove(iter);
-		iter = this->begin();
+	this->releaseSubtree(this->root);
+	while (this->blocks != nullptr) {
+		NodeSlot<T> *block = this->blocks;
+		this->blocks = block->next;
+		delete[] block;
 	}
 }
 
 template<class T>
 AvlTree<T>& AvlTree<T>::operator=(const AvlTree<T>& avlTree) {
-	if (this == &list) {
+	if (this == &avlTree) {
 		return *this;
 	}
-	while (this->head != nullptr) {
-		this->remove(this->begin());
-	}
-	Node<T> *nodeIter = list->head;
-	while (nodeIter != nullptr) {
-		this->insert(nodeIter->data, this->end());
-		nodeIter = nodeIter->next;
+	// the old nodes go back to the reserve, so the copy reuses them
+	this->clear();
+	if (!this->reserve(avlTree.treeSize)) {
+		AVL_TREE_THROW(std::bad_alloc());
 	}
+	this->root = this->copySubtree(avlTree.root, nullptr);
+	this->treeSize = avlTree.treeSize;
+	this->updateExtremes();
+	return *this;
 }
 
 template<class T>
 Iterator<T> AvlTree<T>::begin() {
-	Iterator<T> iter(this->head, this);
+	Iterator<T> iter(this->firstNode, this);
+	return iter;
+}
+
+template<class T>
+Iterator<T> AvlTree<T>::last() {
+	Iterator<T> iter(this->lastNode, this);
 	return iter;
 }
 
@@ -290,61 +561,93 @@ Iterator<T> AvlTree<T>::end() {
 }
 
 template<class T>
-void AvlTree<T>::insert(const T& data, Iterator<T> iterator) {
-	if (iterator.listPtr != this) {
-		throw TreeExceptions::ElementNotFound();
+void AvlTree<T>::insert(const T& data) {
+	if (!this->tryInsert(data)) {
+		AVL_TREE_THROW(std::bad_alloc());
 	}
-	if (iterator.node == nullptr) {
-		if (this->head == nullptr) {
-			this->head = new Node<T>(data, nullptr, nullptr);
-			return;
-		} else {
-			Node<T> *nodeIter = this->head;
-			while (nodeIter->next != nullptr) {
-				nodeIter = nodeIter->next;
-			}
-			Node<T> *newNode = new Node<T>(data, nullptr, nodeIter);
-			nodeIter->next = newNode;
-			return;
-		}
+}
+
+template<class T>
+bool AvlTree<T>::tryInsert(const T& data) {
+	Node<T> *parent = nullptr;
+	Node<T> *nodeIter = this->root;
+	while (nodeIter != nullptr) {
+		parent = nodeIter;
+		nodeIter = (data < nodeIter->data) ? nodeIter->left : nodeIter->right;
 	}
-	Node<T> *iteratorNode = iterator.node;
-	Node<T> *iteratorPrev = iteratorNode->previous;
-	Node<T> *newNode = new Node<T>(data, iteratorNode, iteratorPrev);
-	iteratorNode->previous = newNode;
-	if (iteratorPrev != nullptr) {
-		iteratorPrev->next = newNode;
+	Node<T> *newNode = this->allocateNode(data);
+	if (newNode == nullptr) {
+		return false;
+	}
+	newNode->parent = parent;
+	if (parent == nullptr) {
+		this->root = newNode;
+	} else if (data < parent->data) {
+		parent->left = newNode;
 	} else {
-		this->head = newNode;
+		parent->right = newNode;
 	}
-	return;
+	this->treeSize++;
+	this->rebalance(parent);
+	this->updateExtremes();
+	return true;
 }
 
 template<class T>
 void AvlTree<T>::remove(Iterator<T> iterator) {
+	if (!this->tryRemove(iterator)) {
+		AVL_TREE_THROW(TreeExceptions::ElementNotFound());
+	}
+}
+
+template<class T>
+bool AvlTree<T>::tryRemove(Iterator<T> iterator) {
 
-	if (head == nullptr || iterator.node == nullptr) {
-		throw TreeExceptions::ElementNotFound();
+	if (root == nullptr || iterator.node == nullptr) {
+		return false;
 	}
-	if (iterator.listPtr != this || iterator.listPtr == nullptr) {
-		throw TreeExceptions::ElementNotFound();
+	if (iterator.avlTreePtr != this) {
+		return false;
 	}
 
 	Node<T> *node = iterator.node;
-	if (node->previous != nullptr) {
-		Node<T> *prev = node->previous;
-		prev->next = node->next;
-	}
-	if (node->next != nullptr) {
-		Node<T> *next = node->next;
-		next->previous = node->previous;
-	}
-	if (node->previous == nullptr) {
-		this->head = node->next;
+	Node<T> *rebalanceFrom;
+	if (node->left != nullptr && node->right != nullptr) {
+		// relink the successor's node in place of the removed one, so the
+		// elements never move between nodes and nothing is copied
+		Node<T> *successor = node->right;
+		while (successor->left != nullptr) {
+			successor = successor->left;
+		}
+		if (successor->parent == node) {
+			rebalanceFrom = successor;
+		} else {
+			rebalanceFrom = successor->parent;
+			rebalanceFrom->left = successor->right;
+			if (successor->right != nullptr) {
+				successor->right->parent = rebalanceFrom;
+			}
+			successor->right = node->right;
+			node->right->parent = successor;
+		}
+		successor->left = node->left;
+		node->left->parent = successor;
+		successor->parent = node->parent;
+		this->replaceChild(node->parent, node, successor);
+	} else {
+		Node<T> *child = (node->left != nullptr) ? node->left : node->right;
+		rebalanceFrom = node->parent;
+		if (child != nullptr) {
+			child->parent = rebalanceFrom;
+		}
+		this->replaceChild(rebalanceFrom, node, child);
 	}
-	delete node;
+	this->releaseNode(node);
+	this->treeSize--;
+	this->rebalance(rebalanceFrom);
+	this->updateExtremes();
 
-	return;
+	return true;
 
 }
 
@@ -361,6 +664,372 @@ Iterator<T> AvlTree<T>::find(const Predicate& predicate) {
 	return iter;
 }
 
+template<class T>
+template<class Predicate>
+T* AvlTree<T>::tryFind(const Predicate& predicate) {
+	return this->find(predicate).get();
+}
+
+template<class T>
+Iterator<T> AvlTree<T>::search(const T& data) {
+	return Iterator<T>(this->findNode(data), this);
+}
+
+template<class T>
+bool AvlTree<T>::reserve(int count) {
+	if (count <= this->freeCount) {
+		return true;
+	}
+	return this->addBlock(count - this->freeCount);
+}
+
+template<class T>
+bool AvlTree<T>::buildFromSorted(const T* sorted, int count) {
+	// the current nodes go back to the reserve and are reused by the build
+	if (!this->reserve(count - this->treeSize)) {
+		return false;
+	}
+	this->releaseSubtree(this->root);
+	this->root = this->buildSubtree(sorted, 0, count - 1, nullptr);
+	this->treeSize = count;
+	this->updateExtremes();
+	return true;
+}
+
+template<class T>
+bool AvlTree<T>::merge(AvlTree<T>& avlTree) {
+	if (this == &avlTree || avlTree.treeSize == 0) {
+		return true;
+	}
+	int count = this->treeSize + avlTree.treeSize;
+	Node<T> **nodes = new (std::nothrow) Node<T>*[2 * count];
+	if (nodes == nullptr) {
+		return false;
+	}
+	// flatten both trees side by side, then merge them into the second half
+	flattenSubtree(this->root, nodes, 0);
+	flattenSubtree(avlTree.root, nodes, this->treeSize);
+	Node<T> **merged = nodes + count;
+	int first = 0;
+	int second = this->treeSize;
+	for (int i = 0; i < count; i++) {
+		if (second == count || (first < this->treeSize
+				&& !(nodes[second]->data < nodes[first]->data))) {
+			merged[i] = nodes[first++];
+		} else {
+			merged[i] = nodes[second++];
+		}
+	}
+	this->root = linkSubtree(merged, 0, count - 1, nullptr);
+	this->treeSize = count;
+	this->updateExtremes();
+	delete[] nodes;
+
+	// the moved nodes live in the blocks of the other tree, so take them too
+	if (avlTree.blocks != nullptr) {
+		NodeSlot<T> *lastBlock = avlTree.blocks;
+		while (lastBlock->next != nullptr) {
+			lastBlock = lastBlock->next;
+		}
+		lastBlock->next = this->blocks;
+		this->blocks = avlTree.blocks;
+	}
+	if (avlTree.freeSlots != nullptr) {
+		NodeSlot<T> *lastSlot = avlTree.freeSlots;
+		while (lastSlot->next != nullptr) {
+			lastSlot = lastSlot->next;
+		}
+		lastSlot->next = this->freeSlots;
+		this->freeSlots = avlTree.freeSlots;
+	}
+	this->freeCount += avlTree.freeCount;
+	avlTree.root = nullptr;
+	avlTree.firstNode = nullptr;
+	avlTree.lastNode = nullptr;
+	avlTree.treeSize = 0;
+	avlTree.freeSlots = nullptr;
+	avlTree.freeCount = 0;
+	avlTree.blocks = nullptr;
+	return true;
+}
+
+template<class T>
+void AvlTree<T>::clear() {
+	this->releaseSubtree(this->root);
+	this->root = nullptr;
+	this->treeSize = 0;
+	this->updateExtremes();
+}
+
+template<class T>
+int AvlTree<T>::removeSorted(const T* sorted, int count) {
+	int logSize = 1;
+	while ((1 << logSize) < this->treeSize) {
+		logSize++;
+	}
+	Node<T> **nodes = nullptr;
+	if ((long long) count * logSize >= this->treeSize) {
+		nodes = new (std::nothrow) Node<T>*[this->treeSize + 1];
+	}
+	int removed = 0;
+	if (nodes == nullptr) {
+		// few objects to remove, or no memory for the single pass
+		for (int i = 0; i < count; i++) {
+			Node<T> *node = this->findNode(sorted[i]);
+			if (node != nullptr) {
+				this->tryRemove(Iterator<T>(node, this));
+				removed++;
+			}
+		}
+		return removed;
+	}
+
+	flattenSubtree(this->root, nodes, 0);
+	int kept = 0;
+	int next = 0;
+	for (int i = 0; i < this->treeSize; i++) {
+		while (next < count && sorted[next] < nodes[i]->data) {
+			next++;
+		}
+		if (next < count && !(nodes[i]->data < sorted[next])) {
+			this->releaseNode(nodes[i]);
+			removed++;
+			next++;
+		} else {
+			nodes[kept++] = nodes[i];
+		}
+	}
+	this->root = linkSubtree(nodes, 0, kept - 1, nullptr);
+	this->treeSize = kept;
+	this->updateExtremes();
+	delete[] nodes;
+	return removed;
+}
+
+template<class T>
+int AvlTree<T>::size() const {
+	return this->treeSize;
+}
+
+template<class T>
+int AvlTree<T>::reserved() const {
+	return this->freeCount;
+}
+
+template<class T>
+bool AvlTree<T>::addBlock(int count) {
+	// the first slot of every block links the blocks for the destructor
+	NodeSlot<T> *block = new (std::nothrow) NodeSlot<T>[count + 1];
+	if (block == nullptr) {
+		return false;
+	}
+	block[0].next = this->blocks;
+	this->blocks = block;
+	for (int i = 1; i <= count; i++) {
+		block[i].next = this->freeSlots;
+		this->freeSlots = &block[i];
+	}
+	this->freeCount += count;
+	return true;
+}
+
+template<class T>
+Node<T>* AvlTree<T>::allocateNode(const T& data) {
+	if (this->freeSlots == nullptr) {
+		int count = this->treeSize < MIN_BLOCK_SIZE ?
+				MIN_BLOCK_SIZE : this->treeSize;
+		if (!this->addBlock(count)) {
+			return nullptr;
+		}
+	}
+	NodeSlot<T> *slot = this->freeSlots;
+	this->freeSlots = slot->next;
+	this->freeCount--;
+	return new (slot->storage) Node<T>(data, nullptr, nullptr);
+}
+
+template<class T>
+void AvlTree<T>::releaseNode(Node<T> *node) {
+	node->~Node<T>();
+	NodeSlot<T> *slot = reinterpret_cast<NodeSlot<T>*>(node);
+	slot->next = this->freeSlots;
+	this->freeSlots = slot;
+	this->freeCount++;
+}
+
+template<class T>
+void AvlTree<T>::releaseSubtree(Node<T> *node) {
+	if (node == nullptr) {
+		return;
+	}
+	this->releaseSubtree(node->left);
+	this->releaseSubtree(node->right);
+	this->releaseNode(node);
+}
+
+template<class T>
+Node<T>* AvlTree<T>::copySubtree(const Node<T> *node, Node<T> *parent) {
+	if (node == nullptr) {
+		return nullptr;
+	}
+	Node<T> *newNode = this->allocateNode(node->data);
+	newNode->parent = parent;
+	newNode->height = node->height;
+	newNode->left = this->copySubtree(node->left, newNode);
+	newNode->right = this->copySubtree(node->right, newNode);
+	return newNode;
+}
+
+template<class T>
+Node<T>* AvlTree<T>::buildSubtree(const T* sorted, int low, int high,
+		Node<T> *parent) {
+	if (low > high) {
+		return nullptr;
+	}
+	int middle = low + (high - low) / 2;
+	Node<T> *newNode = this->allocateNode(sorted[middle]);
+	newNode->parent = parent;
+	newNode->left = this->buildSubtree(sorted, low, middle - 1, newNode);
+	newNode->right = this->buildSubtree(sorted, middle + 1, high, newNode);
+	updateHeight(newNode);
+	return newNode;
+}
+
+template<class T>
+Node<T>* AvlTree<T>::findNode(const T& data) const {
+	Node<T> *found = nullptr;
+	Node<T> *nodeIter = this->root;
+	// keep going left on a match, so the first equal element is found
+	while (nodeIter != nullptr) {
+		if (nodeIter->data < data) {
+			nodeIter = nodeIter->right;
+		} else {
+			if (!(data < nodeIter->data)) {
+				found = nodeIter;
+			}
+			nodeIter = nodeIter->left;
+		}
+	}
+	return found;
+}
+
+template<class T>
+int AvlTree<T>::flattenSubtree(Node<T> *node, Node<T> **nodes, int index) {
+	if (node == nullptr) {
+		return index;
+	}
+	index = flattenSubtree(node->left, nodes, index);
+	nodes[index++] = node;
+	return flattenSubtree(node->right, nodes, index);
+}
+
+template<class T>
+Node<T>* AvlTree<T>::linkSubtree(Node<T> **nodes, int low, int high,
+		Node<T> *parent) {
+	if (low > high) {
+		return nullptr;
+	}
+	int middle = low + (high - low) / 2;
+	Node<T> *node = nodes[middle];
+	node->parent = parent;
+	node->left = linkSubtree(nodes, low, middle - 1, node);
+	node->right = linkSubtree(nodes, middle + 1, high, node);
+	updateHeight(node);
+	return node;
+}
+
+template<class T>
+void AvlTree<T>::replaceChild(Node<T> *parent, Node<T> *oldChild,
+		Node<T> *newChild) {
+	if (parent == nullptr) {
+		this->root = newChild;
+	} else if (parent->left == oldChild) {
+		parent->left = newChild;
+	} else {
+		parent->right = newChild;
+	}
+}
+
+template<class T>
+Node<T>* AvlTree<T>::rotateLeft(Node<T> *node) {
+	Node<T> *newTop = node->right;
+	node->right = newTop->left;
+	if (newTop->left != nullptr) {
+		newTop->left->parent = node;
+	}
+	newTop->parent = node->parent;
+	this->replaceChild(node->parent, node, newTop);
+	newTop->left = node;
+	node->parent = newTop;
+	updateHeight(node);
+	updateHeight(newTop);
+	return newTop;
+}
+
+template<class T>
+Node<T>* AvlTree<T>::rotateRight(Node<T> *node) {
+	Node<T> *newTop = node->left;
+	node->left = newTop->right;
+	if (newTop->right != nullptr) {
+		newTop->right->parent = node;
+	}
+	newTop->parent = node->parent;
+	this->replaceChild(node->parent, node, newTop);
+	newTop->right = node;
+	node->parent = newTop;
+	updateHeight(node);
+	updateHeight(newTop);
+	return newTop;
+}
+
+template<class T>
+void AvlTree<T>::rebalance(Node<T> *node) {
+	while (node != nullptr) {
+		updateHeight(node);
+		int balance = balanceFactor(node);
+		if (balance > 1) {
+			if (balanceFactor(node->left) < 0) {
+				this->rotateLeft(node->left);
+			}
+			node = this->rotateRight(node);
+		} else if (balance < -1) {
+			if (balanceFactor(node->right) > 0) {
+				this->rotateRight(node->right);
+			}
+			node = this->rotateLeft(node);
+		}
+		node = node->parent;
+	}
+}
+
+template<class T>
+void AvlTree<T>::updateExtremes() {
+	this->firstNode = this->root;
+	while (this->firstNode != nullptr && this->firstNode->left != nullptr) {
+		this->firstNode = this->firstNode->left;
+	}
+	this->lastNode = this->root;
+	while (this->lastNode != nullptr && this->lastNode->right != nullptr) {
+		this->lastNode = this->lastNode->right;
+	}
+}
+
+template<class T>
+int AvlTree<T>::height(const Node<T> *node) {
+	return (node == nullptr) ? 0 : node->height;
+}
+
+template<class T>
+void AvlTree<T>::updateHeight(Node<T> *node) {
+	int leftHeight = height(node->left);
+	int rightHeight = height(node->right);
+	node->height = 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+}
+
+template<class T>
+int AvlTree<T>::balanceFactor(const Node<T> *node) {
+	return height(node->left) - height(node->right);
+}
 
 /**************End of AvlTree class Functions************/
 
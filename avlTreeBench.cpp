@@ -0,0 +1,399 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : avlTreeBench.cpp                                            */
+/*                                                                         */
+/* Micro-benchmark of the AvlTree operations (avlTree.h), with std::set    */
+/* as the baseline.                                                        */
+/*                                                                         */
+/* Usage: avlTreeBench [-n sizes] [-r repetitions] [-j]                    */
+/*   -n  The tree sizes, separated by commas. Default                      */
+/*       1000,10000,100000,1000000.                                        */
+/*   -r  The number of times each measurement is taken; the median is      */
+/*       reported. Default 3.                                              */
+/*   -j  Writes JSON instead of CSV.                                       */
+/*                                                                         */
+/* Every operation is measured for AvlTree<int> and AvlTree<BenchPokemon>  */
+/* (ordered like the DS's level indexes) and for std::set of both, with    */
+/* the keys in sequential, random and adversarial order. The adversarial   */
+/* order alternates between the smallest and the largest key left, so     */
+/* every insert walks the longest path and rebalances. The trees the other */
+/* operations run on are filled in that order too, so their nodes lie in  */
+/* memory in that order; remove takes the keys in that order, and merge    */
+/* joins the trees of the keys at even and at odd positions in it.        */
+/* buildFromSorted takes sorted keys whatever the order, so it is measured */
+/* once, as sequential.                                                    */
+/*                                                                         */
+/* find is the keyed lookup of both containers: AvlTree::search and      */
+/* std::set::find, for every key. findIf is AvlTree::tryFind, which takes  */
+/* a predicate and scans the tree in order, so it is measured on fewer     */
+/* lookups and has no std::set row.                                        */
+/***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <string>
+#include <vector>
+#include "avlTree.h"
+
+/* The number of tree nodes the findIf measurement visits, about */
+#define FIND_BUDGET (20000000LL)
+
+/* A pokemon as the DS's level indexes order it: higher level first, then
+ * lower ID (pokemon.h is only a skeleton, so the benchmark has its own). */
+struct BenchPokemon {
+	int id;
+	int level;
+	int trainerID;
+
+	bool operator<(const BenchPokemon& pokemon) const {
+		return level != pokemon.level ? level > pokemon.level : id < pokemon.id;
+	}
+	bool operator==(const BenchPokemon& pokemon) const {
+		return id == pokemon.id && level == pokemon.level;
+	}
+};
+
+/* Key i of n for each key type. Pokemons get 100 levels, so their order
+ * differs from their IDs'. */
+static void MakeKey(int i, int n, int& key) {
+	(void) n;
+	key = i;
+}
+
+static void MakeKey(int i, int n, BenchPokemon& key) {
+	(void) n;
+	key.id = i + 1;
+	key.level = 100 - i % 100;
+	key.trainerID = 1;
+}
+
+static const char *TypeName(const int*) {
+	return "int";
+}
+
+static const char *TypeName(const BenchPokemon*) {
+	return "pokemon";
+}
+
+/***************************************************************************/
+/* Measurement                                                             */
+/***************************************************************************/
+
+typedef enum {
+	SEQUENTIAL, RANDOM, ADVERSARIAL
+} Distribution;
+
+static const char *distributionNames[] = { "sequential", "random",
+		"adversarial" };
+
+typedef struct {
+	std::string container;
+	std::string type;
+	std::string distribution;
+	int size;
+	std::string operation;
+	long long operations;
+	double nsPerOperation;
+} Result;
+
+static std::vector<Result> results;
+static int repetitions = 3;
+
+/* The positions of the keys in insertion order */
+static std::vector<int> Order(Distribution distribution, int n) {
+	std::vector<int> order(n);
+	for (int i = 0; i < n; i++) {
+		order[i] = i;
+	}
+	if (distribution == RANDOM) {
+		srand(n);
+		for (int i = n - 1; i > 0; i--) {
+			std::swap(order[i], order[rand() % (i + 1)]);
+		}
+	} else if (distribution == ADVERSARIAL) {
+		for (int i = 0, low = 0, high = n - 1; i < n; i++) {
+			order[i] = (i % 2 == 0) ? low++ : high--;
+		}
+	}
+	return order;
+}
+
+static double Median(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	size_t middle = values.size() / 2;
+	return values.size() % 2 ? values[middle]
+			: (values[middle - 1] + values[middle]) / 2;
+}
+
+/* Runs setup then measured, repetitions times, and records the median time
+ * of measured per operation. */
+template<class Setup, class Measured>
+static void Measure(const char *container, const char *type,
+		Distribution distribution, int size, const char *operation,
+		long long operations, Setup setup, Measured measured) {
+	std::vector<double> times;
+	for (int i = 0; i < repetitions; i++) {
+		setup();
+		std::chrono::steady_clock::time_point start =
+				std::chrono::steady_clock::now();
+		measured();
+		std::chrono::duration<double, std::nano> elapsed =
+				std::chrono::steady_clock::now() - start;
+		times.push_back(elapsed.count() / (operations > 0 ? operations : 1));
+	}
+	Result result = { container, type, distributionNames[distribution], size,
+			operation, operations, Median(times) };
+	results.push_back(result);
+	fprintf(stderr, "%-8s %-8s %-12s %8d %-16s %10.1f ns/op\n", container,
+			type, distributionNames[distribution], size, operation,
+			result.nsPerOperation);
+}
+
+/* Keeps the optimizer from dropping a computed value */
+static volatile long long sink;
+
+/***************************************************************************/
+/* Benchmarks                                                              */
+/***************************************************************************/
+
+template<class T>
+static void BenchAvlTree(Distribution distribution, int n) {
+	const char *type = TypeName((T*) nullptr);
+	std::vector<int> order = Order(distribution, n);
+	std::vector<T> keys(n);
+	std::vector<T> sorted(n);
+	for (int i = 0; i < n; i++) {
+		MakeKey(order[i], n, keys[i]);
+		MakeKey(i, n, sorted[i]);
+	}
+	std::sort(sorted.begin(), sorted.end());
+	int lookups = (int) std::max(10LL, std::min((long long) n,
+			FIND_BUDGET / n));
+
+	AvlTree<T> *tree = nullptr;
+	AvlTree<T> *other = nullptr;
+	auto reset = [&]() {
+		delete tree;
+		delete other;
+		tree = new AvlTree<T>();
+		other = nullptr;
+	};
+	auto fill = [&]() {
+		reset();
+		for (int i = 0; i < n; i++) {
+			tree->insert(keys[i]);
+		}
+	};
+
+	Measure("avltree", type, distribution, n, "insert", n, reset, [&]() {
+		for (int i = 0; i < n; i++) {
+			tree->insert(keys[i]);
+		}
+	});
+	Measure("avltree", type, distribution, n, "find", n, fill, [&]() {
+		long long found = 0;
+		for (int i = 0; i < n; i++) {
+			found += tree->search(keys[i]) != tree->end();
+		}
+		sink = found;
+	});
+	Measure("avltree", type, distribution, n, "findIf", lookups, fill, [&]() {
+		long long found = 0;
+		// keys spread over the whole insertion order
+		for (int i = 0; i < lookups; i++) {
+			const T& key = keys[(long long) i * n / lookups];
+			found += tree->tryFind([&key](const T& data) {
+				return data == key;
+			}) != nullptr;
+		}
+		sink = found;
+	});
+	Measure("avltree", type, distribution, n, "iterate", n, fill, [&]() {
+		long long count = 0;
+		for (Iterator<T> iter = tree->begin(); iter != tree->end(); ++iter) {
+			count++;
+		}
+		sink = count;
+	});
+	Measure("avltree", type, distribution, n, "remove", n, fill, [&]() {
+		for (int i = 0; i < n; i++) {
+			tree->remove(tree->search(keys[i]));
+		}
+	});
+	if (distribution == SEQUENTIAL) {
+		Measure("avltree", type, distribution, n, "buildFromSorted", n, reset,
+				[&]() {
+					tree->buildFromSorted(sorted.data(), n);
+				});
+	}
+	Measure("avltree", type, distribution, n, "merge", n, [&]() {
+		reset();
+		other = new AvlTree<T>();
+		for (int i = 0; i < n; i++) {
+			(i % 2 == 0 ? tree : other)->insert(keys[i]);
+		}
+	}, [&]() {
+		tree->merge(*other);
+	});
+	Measure("avltree", type, distribution, n, "copy", n, fill, [&]() {
+		AvlTree<T> copy(*tree);
+		sink = copy.size();
+	});
+	delete tree;
+	delete other;
+}
+
+template<class T>
+static void BenchStdSet(Distribution distribution, int n) {
+	const char *type = TypeName((T*) nullptr);
+	std::vector<int> order = Order(distribution, n);
+	std::vector<T> keys(n);
+	std::vector<T> sorted(n);
+	for (int i = 0; i < n; i++) {
+		MakeKey(order[i], n, keys[i]);
+		MakeKey(i, n, sorted[i]);
+	}
+	std::sort(sorted.begin(), sorted.end());
+
+	std::set<T> set;
+	std::set<T> other;
+	auto reset = [&]() {
+		set.clear();
+		other.clear();
+	};
+	auto fill = [&]() {
+		reset();
+		for (int i = 0; i < n; i++) {
+			set.insert(keys[i]);
+		}
+	};
+
+	Measure("std::set", type, distribution, n, "insert", n, reset, [&]() {
+		for (int i = 0; i < n; i++) {
+			set.insert(keys[i]);
+		}
+	});
+	Measure("std::set", type, distribution, n, "find", n, fill, [&]() {
+		long long found = 0;
+		for (int i = 0; i < n; i++) {
+			found += set.find(keys[i]) != set.end();
+		}
+		sink = found;
+	});
+	Measure("std::set", type, distribution, n, "iterate", n, fill, [&]() {
+		long long count = 0;
+		for (typename std::set<T>::iterator iter = set.begin();
+				iter != set.end(); ++iter) {
+			count++;
+		}
+		sink = count;
+	});
+	Measure("std::set", type, distribution, n, "remove", n, fill, [&]() {
+		for (int i = 0; i < n; i++) {
+			set.erase(keys[i]);
+		}
+	});
+	if (distribution == SEQUENTIAL) {
+		Measure("std::set", type, distribution, n, "buildFromSorted", n, reset,
+				[&]() {
+					set.insert(sorted.begin(), sorted.end());
+				});
+	}
+	Measure("std::set", type, distribution, n, "merge", n, [&]() {
+		reset();
+		for (int i = 0; i < n; i++) {
+			(i % 2 == 0 ? set : other).insert(keys[i]);
+		}
+	}, [&]() {
+		set.insert(other.begin(), other.end());
+		other.clear();
+	});
+	Measure("std::set", type, distribution, n, "copy", n, fill, [&]() {
+		std::set<T> copy(set);
+		sink = copy.size();
+	});
+}
+
+/***************************************************************************/
+/* Output                                                                  */
+/***************************************************************************/
+
+static void PrintCsv() {
+	printf("container,type,distribution,size,operation,operations,"
+			"ns_per_op\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& result = results[i];
+		printf("%s,%s,%s,%d,%s,%lld,%.2f\n", result.container.c_str(),
+				result.type.c_str(), result.distribution.c_str(), result.size,
+				result.operation.c_str(), result.operations,
+				result.nsPerOperation);
+	}
+}
+
+static void PrintJson() {
+	printf("[\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& result = results[i];
+		printf("  {\"container\": \"%s\", \"type\": \"%s\", "
+				"\"distribution\": \"%s\", \"size\": %d, "
+				"\"operation\": \"%s\", \"operations\": %lld, "
+				"\"ns_per_op\": %.2f}%s\n", result.container.c_str(),
+				result.type.c_str(), result.distribution.c_str(), result.size,
+				result.operation.c_str(), result.operations,
+				result.nsPerOperation, i + 1 < results.size() ? "," : "");
+	}
+	printf("]\n");
+}
+
+int main(int argc, const char**argv) {
+	std::vector<int> sizes;
+	bool json = false;
+	const char *sizesStr = "1000,10000,100000,1000000";
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-j") == 0) {
+			json = true;
+		} else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			sizesStr = argv[++i];
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			repetitions = atoi(argv[++i]);
+		} else {
+			repetitions = 0;
+			break;
+		}
+	}
+	for (const char *str = sizesStr; *str != '\0';) {
+		char *end;
+		long size = strtol(str, &end, 10);
+		if (end == str || size <= 0 || (*end != ',' && *end != '\0')) {
+			sizes.clear();
+			break;
+		}
+		sizes.push_back((int) size);
+		str = (*end == ',') ? end + 1 : end;
+	}
+	if (repetitions <= 0 || sizes.empty()) {
+		fprintf(stderr, "usage: %s [-n sizes] [-r repetitions] [-j]\n",
+				argv[0]);
+		return 1;
+	}
+
+	for (size_t i = 0; i < sizes.size(); i++) {
+		for (int distribution = SEQUENTIAL; distribution <= ADVERSARIAL;
+				distribution++) {
+			BenchAvlTree<int>((Distribution) distribution, sizes[i]);
+			BenchStdSet<int>((Distribution) distribution, sizes[i]);
+			BenchAvlTree<BenchPokemon>((Distribution) distribution, sizes[i]);
+			BenchStdSet<BenchPokemon>((Distribution) distribution, sizes[i]);
+		}
+	}
+	if (json) {
+		PrintJson();
+	} else {
+		PrintCsv();
+	}
+	return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef BINARYPROTOCOL_H_
+#define BINARYPROTOCOL_H_
+#include <stdint.h>
+
+/*
+ * Binary framing of the shell's commands, read by main1 -b and written by
+ * textToBinary from text traces.
+ *
+ * A stream starts with the 8 bytes of BINARY_MAGIC, followed by records.
+ * A record is an opcode byte followed by the command's int32 arguments, as
+ * many as BinaryOpArgs gives for the opcode, in the order the text command
+ * takes them. BINARY_COMMENT is followed by an int32 length and that many
+ * bytes of text, echoed as is (the text shell echoes '#' lines), so a
+ * converted trace prints exactly what the text trace prints.
+ * Integers are stored in the byte order of the machine that wrote the
+ * stream, as in the snapshot and log files.
+ */
+
+#define BINARY_MAGIC "PKMNCMDS"
+#define BINARY_MAGIC_SIZE (8)
+
+typedef enum {
+	BINARY_INIT = 1,
+	BINARY_ADD_TRAINER = 2,
+	BINARY_CATCH_POKEMON = 3,
+	BINARY_FREE_POKEMON = 4,
+	BINARY_LEVEL_UP = 5,
+	BINARY_EVOLVE_POKEMON = 6,
+	BINARY_GET_TOP_POKEMON = 7,
+	BINARY_GET_ALL_POKEMONS_BY_LEVEL = 8,
+	BINARY_UPDATE_LEVELS = 9,
+	BINARY_QUIT = 10,
+	BINARY_COMMENT = 11
+} BinaryOp;
+
+#define BINARY_MAX_ARGS (3)
+
+/* Description:   The number of int32 arguments following an opcode.
+ * Input:         op - The opcode.
+ * Output:        None.
+ * Return Values: The number of arguments (the comment's length for
+ *                BINARY_COMMENT), or -1 if op isn't a valid opcode.
+ */
+static inline int BinaryOpArgs(int op) {
+	static const int args[] = { -1, 0, 1, 3, 1, 2, 2, 1, 1, 2, 0, 1 };
+	return (op >= BINARY_INIT && op <= BINARY_COMMENT) ? args[op] : -1;
+}
+
+#endif /* BINARYPROTOCOL_H_ */
@@ -0,0 +1,148 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : changeFeed.cpp                                              */
+/*                                                                         */
+/* Encoding and batching of the change feed described in changeFeed.h.     */
+/***************************************************************************/
+
+#include <stdlib.h>
+#include "changeFeed.h"
+
+/* Returns the number of arguments of an event type, or -1 for an unknown type. */
+static int FeedNumOfArgs(int type) {
+	switch (type) {
+	case FEED_FREED:
+	case FEED_TRAINER_ADDED:
+	case FEED_TRAINER_REMOVED:
+		return 1;
+	case FEED_LEVEL_CHANGED:
+	case FEED_EVOLVED:
+	case FEED_LEVELS_UPDATED:
+	case FEED_TRANSFERRED:
+	case FEED_TRANSFERRED_ALL:
+		return 2;
+	case FEED_CAUGHT:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+static size_t EncodeVarint(unsigned char *out, int value) {
+	uint32_t zigzag = ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+	size_t size = 0;
+	while (zigzag >= 0x80) {
+		out[size++] = (unsigned char) (zigzag | 0x80);
+		zigzag >>= 7;
+	}
+	out[size++] = (unsigned char) zigzag;
+	return size;
+}
+
+/* Returns the number of bytes read, or 0 if the varint is truncated or too long. */
+static size_t DecodeVarint(const unsigned char *in, size_t size, int *value) {
+	uint32_t zigzag = 0;
+	for (size_t i = 0; i < size && i < 5; i++) {
+		zigzag |= (uint32_t) (in[i] & 0x7F) << (7 * i);
+		if ((in[i] & 0x80) == 0) {
+			*value = (int) ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+/***************************************************************************/
+/* ChangeFeedOpen                                                          */
+/***************************************************************************/
+ChangeFeed* ChangeFeedOpen(ChangeFeedSink sink, void *context, int batchSize) {
+	if (sink == NULL || batchSize < 1) {
+		return NULL;
+	}
+	ChangeFeed *feed = (ChangeFeed*) malloc(sizeof(ChangeFeed));
+	if (feed == NULL) {
+		return NULL;
+	}
+	// room for a full batch plus the event that completes it
+	feed->buffer = (unsigned char*) malloc(batchSize + FEED_MAX_EVENT_SIZE);
+	if (feed->buffer == NULL) {
+		free(feed);
+		return NULL;
+	}
+	feed->sink = sink;
+	feed->context = context;
+	feed->used = 0;
+	feed->batchSize = batchSize;
+	return feed;
+}
+
+/***************************************************************************/
+/* ChangeFeedEmit                                                          */
+/***************************************************************************/
+StatusType ChangeFeedEmit(ChangeFeed *feed, const FeedEvent *event) {
+	if (feed == NULL || event == NULL
+			|| FeedNumOfArgs(event->type) != event->numOfArgs) {
+		return INVALID_INPUT;
+	}
+	unsigned char *out = feed->buffer + feed->used;
+	size_t size = 0;
+	out[size++] = (unsigned char) event->type;
+	for (int i = 0; i < event->numOfArgs; i++) {
+		size += EncodeVarint(out + size, event->args[i]);
+	}
+	feed->used += size;
+	if (feed->used >= feed->batchSize) {
+		ChangeFeedFlush(feed);
+	}
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* ChangeFeedFlush                                                         */
+/***************************************************************************/
+void ChangeFeedFlush(ChangeFeed *feed) {
+	if (feed == NULL || feed->used == 0) {
+		return;
+	}
+	feed->sink(feed->buffer, feed->used, feed->context);
+	feed->used = 0;
+}
+
+/***************************************************************************/
+/* ChangeFeedClose                                                         */
+/***************************************************************************/
+void ChangeFeedClose(ChangeFeed **feed) {
+	if (feed == NULL || *feed == NULL) {
+		return;
+	}
+	ChangeFeedFlush(*feed);
+	free((*feed)->buffer);
+	free(*feed);
+	*feed = NULL;
+}
+
+/***************************************************************************/
+/* ChangeFeedDecode                                                        */
+/***************************************************************************/
+size_t ChangeFeedDecode(const unsigned char *events, size_t size,
+		FeedEvent *event) {
+	if (events == NULL || event == NULL || size == 0) {
+		return 0;
+	}
+	int numOfArgs = FeedNumOfArgs(events[0]);
+	if (numOfArgs < 0) {
+		return 0;
+	}
+	event->type = (FeedEventType) events[0];
+	event->numOfArgs = numOfArgs;
+	size_t position = 1;
+	for (int i = 0; i < numOfArgs; i++) {
+		size_t read = DecodeVarint(events + position, size - position,
+				&event->args[i]);
+		if (read == 0) {
+			return 0;
+		}
+		position += read;
+	}
+	return position;
+}
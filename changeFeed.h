@@ -0,0 +1,110 @@
+#ifndef CHANGEFEED_H_
+#define CHANGEFEED_H_
+#include <stddef.h>
+#include <stdint.h>
+#include "library1.h"
+
+/*
+ * Change feed - a stream of compact binary events describing every change
+ * the DS makes to its level indexes, for mirrors that apply deltas instead of
+ * pulling GetAllPokemonsByLevel.
+ *
+ * A DS with a feed attached (see SetChangeFeed in library1.h) emits one event
+ * per successful mutation from its mutation paths. Events are batched and
+ * handed to the sink of the feed once batchSize bytes are pending, or on
+ * ChangeFeedFlush. An event is its type byte followed by its arguments, each
+ * a zigzag varint:
+ *   FEED_CAUGHT          pokemonID, trainerID, level
+ *   FEED_FREED           pokemonID
+ *   FEED_LEVEL_CHANGED   pokemonID, newLevel
+ *   FEED_EVOLVED         pokemonID, evolvedID
+ *   FEED_LEVELS_UPDATED  stoneCode, stoneFactor - every pokemon whose
+ *                        pokemonID % stoneCode == 0 had its level multiplied
+ *                        by stoneFactor.
+ *   FEED_TRAINER_ADDED   trainerID - a trainer with an empty level index.
+ *   FEED_TRANSFERRED     pokemonID, newTrainerID
+ *   FEED_TRANSFERRED_ALL fromTrainerID, toTrainerID - every pokemon of
+ *                        fromTrainerID moved to toTrainerID.
+ *   FEED_TRAINER_REMOVED trainerID - the trainer and all its pokemons.
+ */
+
+typedef enum {
+	FEED_CAUGHT = 1,
+	FEED_FREED = 2,
+	FEED_LEVEL_CHANGED = 3,
+	FEED_EVOLVED = 4,
+	FEED_LEVELS_UPDATED = 5,
+	FEED_TRAINER_ADDED = 6,
+	FEED_TRANSFERRED = 7,
+	FEED_TRANSFERRED_ALL = 8,
+	FEED_TRAINER_REMOVED = 9
+} FeedEventType;
+
+#define FEED_MAX_ARGS        (3)
+#define FEED_MAX_EVENT_SIZE  (1 + 5 * FEED_MAX_ARGS)
+
+typedef struct {
+	FeedEventType type;
+	int numOfArgs;
+	int args[FEED_MAX_ARGS];
+} FeedEvent;
+
+/* Receives a batch of encoded events. The batch is only valid during the call. */
+typedef void (*ChangeFeedSink)(const unsigned char *events, size_t size,
+		void *context);
+
+struct ChangeFeed {
+	ChangeFeedSink sink;
+	void *context;
+	unsigned char *buffer;
+	size_t used;
+	size_t batchSize;
+};
+
+/* Description:   Creates a change feed.
+ * Input:         sink - Called with every batch of events.
+ *                context - Passed to sink.
+ *                batchSize - The number of bytes gathered before calling sink.
+ *                1 hands every event to sink as soon as it is emitted.
+ * Output:        None.
+ * Return Values: The feed, or NULL if sink==NULL, batchSize < 1, or in case of an allocation error.
+ */
+ChangeFeed* ChangeFeedOpen(ChangeFeedSink sink, void *context, int batchSize);
+
+/* Description:   Encodes an event into the feed. Called by the DS from its
+ *                mutation paths; an event with the wrong number of arguments
+ *                for its type is not emitted.
+ * Input:         feed - The feed.
+ *                event - The event to emit.
+ * Output:        None.
+ * Return Values: INVALID_INPUT - If any of the arguments is NULL, or the event is malformed.
+ *                SUCCESS - Otherwise.
+ */
+StatusType ChangeFeedEmit(ChangeFeed *feed, const FeedEvent *event);
+
+/* Description:   Hands the pending events to the sink.
+ * Input:         feed - The feed.
+ * Output:        None.
+ * Return Values: None.
+ */
+void ChangeFeedFlush(ChangeFeed *feed);
+
+/* Description:   Flushes and releases a feed. feed should be set to NULL.
+ *                Detach it from the DS (SetChangeFeed(DS, NULL)) first.
+ * Input:         feed - A pointer to the feed.
+ * Output:        None.
+ * Return Values: None.
+ */
+void ChangeFeedClose(ChangeFeed **feed);
+
+/* Description:   Decodes the first event of a batch, for mirrors.
+ * Input:         events - The encoded events.
+ *                size - The number of bytes in events.
+ * Output:        event - Updated to the decoded event.
+ * Return Values: The number of bytes the event took, or 0 if events doesn't
+ *                start with a complete, valid event.
+ */
+size_t ChangeFeedDecode(const unsigned char *events, size_t size,
+		FeedEvent *event);
+
+#endif /* CHANGEFEED_H_ */
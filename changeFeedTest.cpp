@@ -0,0 +1,230 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : changeFeedTest.cpp                                          */
+/*                                                                         */
+/* Tests of the change feed described in changeFeed.h: every event type   */
+/* survives an encode/decode round trip, malformed input is rejected, and  */
+/* the DS emits the event of every successful mutation and nothing else.   */
+/*                                                                         */
+/* Usage: changeFeedTest                                                   */
+/*                                                                         */
+/* Built from changeFeedTest.cpp, changeFeed.cpp and library1.cpp with its */
+/* dependencies. Prints every failed check and exits with 1 if any        */
+/* failed, 0 otherwise.                                                    */
+/***************************************************************************/
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "changeFeed.h"
+#include "library1.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+					#condition); \
+			failures++; \
+		} \
+	} while (0)
+
+/* Gathers every batch the feed hands to its sink. */
+typedef struct {
+	unsigned char bytes[1 << 16];
+	size_t size;
+	int numOfBatches;
+} Collected;
+
+static void Collect(const unsigned char *events, size_t size, void *context) {
+	Collected *collected = (Collected*) context;
+	if (collected->size + size <= sizeof(collected->bytes)) {
+		memcpy(collected->bytes + collected->size, events, size);
+		collected->size += size;
+	}
+	collected->numOfBatches++;
+}
+
+static FeedEvent MakeEvent(FeedEventType type, int numOfArgs, int arg0,
+		int arg1, int arg2) {
+	FeedEvent event;
+	event.type = type;
+	event.numOfArgs = numOfArgs;
+	event.args[0] = arg0;
+	event.args[1] = arg1;
+	event.args[2] = arg2;
+	return event;
+}
+
+static bool SameEvent(const FeedEvent& a, const FeedEvent& b) {
+	if (a.type != b.type || a.numOfArgs != b.numOfArgs) {
+		return false;
+	}
+	for (int i = 0; i < a.numOfArgs; i++) {
+		if (a.args[i] != b.args[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Decodes every event of collected and compares them with expected. */
+static void CheckDecoded(const Collected& collected, const FeedEvent *expected,
+		int numOfExpected) {
+	size_t position = 0;
+	int count = 0;
+	while (position < collected.size) {
+		FeedEvent event;
+		size_t read = ChangeFeedDecode(collected.bytes + position,
+				collected.size - position, &event);
+		CHECK(read > 0);
+		if (read == 0) {
+			return;
+		}
+		CHECK(count < numOfExpected && SameEvent(event, expected[count]));
+		position += read;
+		count++;
+	}
+	CHECK(count == numOfExpected);
+}
+
+/***************************************************************************/
+/* Codec                                                                   */
+/***************************************************************************/
+
+/* One event of every type, with the arguments at the edges of the varints. */
+static const int numOfSamples = 9;
+
+static void Samples(FeedEvent *samples) {
+	samples[0] = MakeEvent(FEED_CAUGHT, 3, 1, INT_MAX, INT_MIN);
+	samples[1] = MakeEvent(FEED_FREED, 1, 0, 0, 0);
+	samples[2] = MakeEvent(FEED_LEVEL_CHANGED, 2, 63, -64, 0);
+	samples[3] = MakeEvent(FEED_EVOLVED, 2, 64, -65, 0);
+	samples[4] = MakeEvent(FEED_LEVELS_UPDATED, 2, -1, 1 << 28, 0);
+	samples[5] = MakeEvent(FEED_TRAINER_ADDED, 1, 123456789, 0, 0);
+	samples[6] = MakeEvent(FEED_TRANSFERRED, 2, 8191, 8192, 0);
+	samples[7] = MakeEvent(FEED_TRANSFERRED_ALL, 2, -8193, 1, 0);
+	samples[8] = MakeEvent(FEED_TRAINER_REMOVED, 1, -1048577, 0, 0);
+}
+
+static void TestRoundTrip(int batchSize) {
+	FeedEvent samples[numOfSamples];
+	Samples(samples);
+	Collected collected;
+	collected.size = 0;
+	collected.numOfBatches = 0;
+	ChangeFeed *feed = ChangeFeedOpen(Collect, &collected, batchSize);
+	CHECK(feed != NULL);
+	if (feed == NULL) {
+		return;
+	}
+	for (int i = 0; i < numOfSamples; i++) {
+		CHECK(ChangeFeedEmit(feed, &samples[i]) == SUCCESS);
+	}
+	if (batchSize == 1) {
+		CHECK(collected.numOfBatches == numOfSamples);
+	}
+	ChangeFeedClose(&feed);
+	CHECK(feed == NULL);
+	CheckDecoded(collected, samples, numOfSamples);
+}
+
+static void TestMalformed() {
+	Collected collected;
+	collected.size = 0;
+	collected.numOfBatches = 0;
+	ChangeFeed *feed = ChangeFeedOpen(Collect, &collected, 1);
+	FeedEvent wrongArgs = MakeEvent(FEED_CAUGHT, 2, 1, 2, 0);
+	FeedEvent unknownType = MakeEvent((FeedEventType) 0, 0, 0, 0, 0);
+	CHECK(ChangeFeedEmit(feed, &wrongArgs) == INVALID_INPUT);
+	CHECK(ChangeFeedEmit(feed, &unknownType) == INVALID_INPUT);
+	CHECK(ChangeFeedEmit(NULL, &wrongArgs) == INVALID_INPUT);
+	CHECK(collected.numOfBatches == 0);
+
+	// every proper prefix of an event is incomplete
+	FeedEvent event = MakeEvent(FEED_CAUGHT, 3, INT_MIN, INT_MAX, -1);
+	CHECK(ChangeFeedEmit(feed, &event) == SUCCESS);
+	FeedEvent decoded;
+	for (size_t size = 0; size < collected.size; size++) {
+		CHECK(ChangeFeedDecode(collected.bytes, size, &decoded) == 0);
+	}
+	CHECK(ChangeFeedDecode(collected.bytes, collected.size, &decoded)
+			== collected.size);
+
+	// an unknown type, and a varint longer than 5 bytes
+	const unsigned char unknown[] = { 0x7F, 0x01 };
+	const unsigned char tooLong[] = { FEED_FREED, 0x80, 0x80, 0x80, 0x80, 0x80,
+			0x01 };
+	CHECK(ChangeFeedDecode(unknown, sizeof(unknown), &decoded) == 0);
+	CHECK(ChangeFeedDecode(tooLong, sizeof(tooLong), &decoded) == 0);
+	ChangeFeedClose(&feed);
+}
+
+/***************************************************************************/
+/* Emission from the DS                                                    */
+/***************************************************************************/
+static void TestEmission() {
+	Collected collected;
+	collected.size = 0;
+	collected.numOfBatches = 0;
+	ChangeFeed *feed = ChangeFeedOpen(Collect, &collected, 64);
+	void *DS = Init();
+	CHECK(DS != NULL && SetChangeFeed(DS, feed) == SUCCESS);
+	if (DS == NULL) {
+		ChangeFeedClose(&feed);
+		return;
+	}
+
+	CHECK(AddTrainer(DS, 7) == SUCCESS);
+	CHECK(CatchPokemon(DS, 10, 7, 5) == SUCCESS);
+	CHECK(CatchPokemon(DS, 11, 7, 3) == SUCCESS);
+	CHECK(LevelUp(DS, 11, 4) == SUCCESS);
+	CHECK(EvolvePokemon(DS, 10, 20) == SUCCESS);
+	CHECK(UpdateLevels(DS, 2, 3) == SUCCESS);
+	CHECK(FreePokemon(DS, 11) == SUCCESS);
+	CHECK(AddTrainer(DS, 9) == SUCCESS);
+	CHECK(TransferPokemon(DS, 20, 9) == SUCCESS);
+	CHECK(TransferAll(DS, 9, 7) == SUCCESS);
+	// failed mutations emit nothing
+	CHECK(AddTrainer(DS, 7) == FAILURE);
+	CHECK(CatchPokemon(DS, 20, 7, 1) == FAILURE);
+	CHECK(FreePokemon(DS, 11) == FAILURE);
+	CHECK(LevelUp(DS, 0, 1) == INVALID_INPUT);
+	CHECK(TransferPokemon(DS, 20, 5) == FAILURE);
+	CHECK(TransferAll(DS, 5, 7) == FAILURE);
+	CHECK(RemoveTrainer(DS, 5) == FAILURE);
+	CHECK(RemoveTrainer(DS, 7) == SUCCESS);
+
+	// a detached feed gets nothing more
+	CHECK(SetChangeFeed(DS, NULL) == SUCCESS);
+	CHECK(AddTrainer(DS, 8) == SUCCESS);
+	ChangeFeedClose(&feed);
+
+	const FeedEvent expected[] = { MakeEvent(FEED_TRAINER_ADDED, 1, 7, 0, 0),
+			MakeEvent(FEED_CAUGHT, 3, 10, 7, 5),
+			MakeEvent(FEED_CAUGHT, 3, 11, 7, 3),
+			MakeEvent(FEED_LEVEL_CHANGED, 2, 11, 7, 0),
+			MakeEvent(FEED_EVOLVED, 2, 10, 20, 0),
+			MakeEvent(FEED_LEVELS_UPDATED, 2, 2, 3, 0),
+			MakeEvent(FEED_FREED, 1, 11, 0, 0),
+			MakeEvent(FEED_TRAINER_ADDED, 1, 9, 0, 0),
+			MakeEvent(FEED_TRANSFERRED, 2, 20, 9, 0),
+			MakeEvent(FEED_TRANSFERRED_ALL, 2, 9, 7, 0),
+			MakeEvent(FEED_TRAINER_REMOVED, 1, 7, 0, 0) };
+	CheckDecoded(collected, expected, sizeof(expected) / sizeof(expected[0]));
+	Quit(&DS);
+}
+
+int main() {
+	TestRoundTrip(1);
+	TestRoundTrip(1024);
+	TestMalformed();
+	TestEmission();
+	if (failures > 0) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	printf("changeFeedTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,242 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : checkpoint.cpp                                              */
+/*                                                                         */
+/* Background checkpoints of a logged DS, described in checkpoint.h.       */
+/***************************************************************************/
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "checkpoint.h"
+#include "snapshot.h"
+
+#define CHECKPOINT_MANIFEST "CHECKPOINT"
+#define CHECKPOINT_SNAPSHOT "snapshot"
+#define CHECKPOINT_WAL      "wal"
+
+/* Builds dir/name.generation in path, which holds PATH_MAX bytes. */
+static bool MakePath(char *path, const char *dir, const char *name,
+		int64_t generation) {
+	int length = snprintf(path, PATH_MAX, "%s/%s.%lld", dir, name,
+			(long long) generation);
+	return length > 0 && length < PATH_MAX;
+}
+
+static bool Exists(const char *path) {
+	return access(path, F_OK) == 0;
+}
+
+/* Returns the generation of the newest complete snapshot, 0 if there is none
+ * and -1 if the manifest can't be read. */
+static int64_t ReadManifest(const char *dir) {
+	char path[PATH_MAX];
+	if (snprintf(path, PATH_MAX, "%s/%s", dir, CHECKPOINT_MANIFEST)
+			>= PATH_MAX) {
+		return -1;
+	}
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return (errno == ENOENT) ? 0 : -1;
+	}
+	long long generation = -1;
+	if (fscanf(file, "%lld", &generation) != 1 || generation < 0) {
+		generation = -1;
+	}
+	fclose(file);
+	return generation;
+}
+
+static StatusType WriteManifest(const char *dir, int64_t generation) {
+	char path[PATH_MAX];
+	char content[32];
+	if (snprintf(path, PATH_MAX, "%s/%s", dir, CHECKPOINT_MANIFEST)
+			>= PATH_MAX) {
+		return FAILURE;
+	}
+	size_t size = snprintf(content, sizeof(content), "%lld\n",
+			(long long) generation);
+	const void *sections[] = { content };
+	return SnapshotWriteFile(path, sections, &size, 1);
+}
+
+/***************************************************************************/
+/* CheckpointOpen                                                          */
+/***************************************************************************/
+Checkpointer* CheckpointOpen(const char *dir, int groupSize, int maxDelayMs,
+		void **DS) {
+	char path[PATH_MAX];
+	if (dir == NULL || DS == NULL) {
+		return NULL;
+	}
+	int64_t generation = ReadManifest(dir);
+	if (generation < 0) {
+		return NULL;
+	}
+	if (generation > 0) {
+		if (!MakePath(path, dir, CHECKPOINT_SNAPSHOT, generation)) {
+			return NULL;
+		}
+		*DS = LoadSnapshot(path);
+	} else {
+		*DS = Init();
+	}
+	if (*DS == NULL) {
+		return NULL;
+	}
+
+	// replay the segment of the snapshot and every newer one
+	int64_t last = generation;
+	bool ok = true;
+	for (int64_t g = generation; ok; g++) {
+		ok = MakePath(path, dir, CHECKPOINT_WAL, g);
+		if (ok && !Exists(path)) {
+			break;
+		}
+		ok = ok && WalReplay(path, *DS, NULL) == SUCCESS;
+		last = g;
+	}
+
+	Checkpointer *checkpointer = NULL;
+	if (ok && MakePath(path, dir, CHECKPOINT_WAL, last)) {
+		checkpointer = (Checkpointer*) malloc(sizeof(Checkpointer));
+	}
+	if (checkpointer != NULL) {
+		checkpointer->dir = strdup(dir);
+		checkpointer->wal = WalOpen(path, groupSize, maxDelayMs);
+		checkpointer->generation = last;
+		// the segment may have just been created
+		if (checkpointer->wal != NULL
+				&& SnapshotSyncDirectory(path) != SUCCESS) {
+			WalClose(&checkpointer->wal);
+		}
+		checkpointer->checkpointGeneration = 0;
+		checkpointer->child = 0;
+		checkpointer->groupSize = groupSize;
+		checkpointer->maxDelayMs = maxDelayMs;
+		if (checkpointer->dir == NULL || checkpointer->wal == NULL) {
+			WalClose(&checkpointer->wal);
+			free(checkpointer->dir);
+			free(checkpointer);
+			checkpointer = NULL;
+		}
+	}
+	if (checkpointer == NULL) {
+		Quit(DS);
+	}
+	return checkpointer;
+}
+
+/***************************************************************************/
+/* CheckpointWal                                                           */
+/***************************************************************************/
+Wal* CheckpointWal(Checkpointer *checkpointer) {
+	return (checkpointer == NULL) ? NULL : checkpointer->wal;
+}
+
+/***************************************************************************/
+/* CheckpointStart                                                         */
+/***************************************************************************/
+StatusType CheckpointStart(Checkpointer *checkpointer, void *DS) {
+	char walPath[PATH_MAX];
+	char snapshotPath[PATH_MAX];
+	if (checkpointer == NULL || DS == NULL) {
+		return INVALID_INPUT;
+	}
+	int64_t generation = checkpointer->generation + 1;
+	if (checkpointer->child > 0
+			|| !MakePath(walPath, checkpointer->dir, CHECKPOINT_WAL, generation)
+			|| !MakePath(snapshotPath, checkpointer->dir, CHECKPOINT_SNAPSHOT,
+					generation)
+			|| WalCommit(checkpointer->wal) != SUCCESS) {
+		return FAILURE;
+	}
+	Wal *wal = WalOpen(walPath, checkpointer->groupSize,
+			checkpointer->maxDelayMs);
+	if (wal == NULL) {
+		return FAILURE;
+	}
+	// the records of the new segment are durable only once its directory
+	// entry is
+	if (SnapshotSyncDirectory(walPath) != SUCCESS) {
+		WalClose(&wal);
+		return FAILURE;
+	}
+	WalClose(&checkpointer->wal);
+	checkpointer->wal = wal;
+	checkpointer->generation = generation;
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		return FAILURE;
+	}
+	if (pid == 0) {
+		// the child's copy of the DS is frozen at the start of the new segment
+		_exit(SaveSnapshot(DS, snapshotPath) == SUCCESS ? 0 : 1);
+	}
+	checkpointer->child = pid;
+	checkpointer->checkpointGeneration = generation;
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* CheckpointPoll                                                          */
+/***************************************************************************/
+StatusType CheckpointPoll(Checkpointer *checkpointer, bool wait) {
+	char path[PATH_MAX];
+	if (checkpointer == NULL) {
+		return INVALID_INPUT;
+	}
+	if (checkpointer->child <= 0) {
+		return SUCCESS;
+	}
+	int status;
+	pid_t res;
+	do {
+		res = waitpid(checkpointer->child, &status, wait ? 0 : WNOHANG);
+	} while (res < 0 && errno == EINTR);
+	if (res == 0) {
+		return SUCCESS;
+	}
+	checkpointer->child = 0;
+	int64_t generation = checkpointer->checkpointGeneration;
+	if (res < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0
+			|| WriteManifest(checkpointer->dir, generation) != SUCCESS) {
+		return FAILURE;
+	}
+
+	// everything older than the published snapshot is no longer needed
+	for (int64_t g = generation - 1; g >= 0; g--) {
+		bool found = false;
+		if (MakePath(path, checkpointer->dir, CHECKPOINT_WAL, g)
+				&& unlink(path) == 0) {
+			found = true;
+		}
+		if (MakePath(path, checkpointer->dir, CHECKPOINT_SNAPSHOT, g)
+				&& unlink(path) == 0) {
+			found = true;
+		}
+		if (!found) {
+			break;
+		}
+	}
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* CheckpointClose                                                         */
+/***************************************************************************/
+void CheckpointClose(Checkpointer **checkpointer) {
+	if (checkpointer == NULL || *checkpointer == NULL) {
+		return;
+	}
+	CheckpointPoll(*checkpointer, true);
+	WalClose(&(*checkpointer)->wal);
+	free((*checkpointer)->dir);
+	free(*checkpointer);
+	*checkpointer = NULL;
+}
@@ -0,0 +1,89 @@
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+#include <stdint.h>
+#include <sys/types.h>
+#include "library1.h"
+#include "wal.h"
+
+/*
+ * Checkpointing of a logged DS, so recovery replays a bounded amount of log.
+ *
+ * A checkpoint directory holds numbered generations: snapshot.<n> is a
+ * snapshot (see snapshot.h) of the DS before any record of wal.<n>, and the
+ * CHECKPOINT file names the newest complete snapshot. Recovery loads that
+ * snapshot and replays wal.<n>, wal.<n+1>, ... (a newer segment exists when
+ * the process stopped during a checkpoint).
+ *
+ * CheckpointStart commits the log, moves logging to a new segment and forks.
+ * The child writes the snapshot from its copy-on-write image of the DS while
+ * the parent keeps serving mutations, so the DS is frozen only for the commit
+ * and the fork. CheckpointPoll collects the child, publishes the snapshot and
+ * deletes the segments and snapshots it made obsolete.
+ * The directory is synced after every segment it creates and every file it
+ * renames into place (the snapshots and CHECKPOINT), so they survive a crash
+ * along with their contents.
+ * The snapshot is written by the child with SaveSnapshot, so checkpoints
+ * should be started from the thread that owns the DS, while no other thread
+ * holds locks the child needs (for example, in the middle of malloc).
+ */
+
+typedef struct {
+	char *dir;
+	Wal *wal;
+	int64_t generation;
+	int64_t checkpointGeneration;
+	pid_t child;
+	int groupSize;
+	int maxDelayMs;
+} Checkpointer;
+
+/* Description:   Recovers the DS kept in a checkpoint directory and opens its
+ *                newest log segment for appending.
+ * Input:         dir - The checkpoint directory. It must exist; an empty
+ *                directory holds an empty DS.
+ *                groupSize, maxDelayMs - The group commit settings of the log (see WalOpen).
+ * Output:        DS - Updated to the recovered instance of the data structure.
+ * Return Values: The checkpointer, or NULL if any of the arguments is invalid,
+ *                the directory can't be recovered or in case of an allocation error.
+ */
+Checkpointer* CheckpointOpen(const char *dir, int groupSize, int maxDelayMs,
+		void **DS);
+
+/* Description:   Returns the log the mutations of the DS should go through
+ *                (see the Wal* functions of wal.h). It changes on every
+ *                CheckpointStart, so don't keep it across checkpoints.
+ */
+Wal* CheckpointWal(Checkpointer *checkpointer);
+
+/* Description:   Starts a checkpoint of the DS in the background.
+ * Input:         checkpointer - The checkpointer.
+ *                DS - A pointer to the data structure, as logged so far.
+ * Output:        None.
+ * Return Values: INVALID_INPUT - If checkpointer==NULL or DS==NULL.
+ *                FAILURE - If a checkpoint is already running, or committing
+ *                the log, opening a new segment or forking failed.
+ *                SUCCESS - Otherwise.
+ */
+StatusType CheckpointStart(Checkpointer *checkpointer, void *DS);
+
+/* Description:   Completes the running checkpoint once its snapshot is written.
+ * Input:         checkpointer - The checkpointer.
+ *                wait - If true, waits for the running checkpoint to finish.
+ * Output:        None.
+ * Return Values: INVALID_INPUT - If checkpointer==NULL.
+ *                FAILURE - If the checkpoint failed. The log segments are kept,
+ *                so recovery is still complete, only longer.
+ *                SUCCESS - If there is no running checkpoint, the running
+ *                checkpoint is still writing (and wait is false), or it completed.
+ */
+StatusType CheckpointPoll(Checkpointer *checkpointer, bool wait);
+
+/* Description:   Waits for a running checkpoint, commits and closes the log.
+ *                checkpointer should be set to NULL.
+ * Input:         checkpointer - A pointer to the checkpointer.
+ * Output:        None.
+ * Return Values: None.
+ */
+void CheckpointClose(Checkpointer **checkpointer);
+
+#endif /* CHECKPOINT_H_ */
@@ -0,0 +1,294 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : checkpointTest.cpp                                          */
+/*                                                                         */
+/* Tests of the checkpoints described in checkpoint.h: a DS recovered     */
+/* from a checkpoint directory equals the one that was logged into it,    */
+/* CheckpointPoll deletes the generations a published snapshot made       */
+/* obsolete and keeps them when the checkpoint fails, and recovery cuts a */
+/* torn tail of the newest segment.                                        */
+/*                                                                         */
+/* Usage: checkpointTest                                                   */
+/*                                                                         */
+/* Built from checkpointTest.cpp and library1.cpp with its dependencies.  */
+/* Creates and removes a checkpointTest.XXXXXX directory in the working   */
+/* directory. Prints every failed check and exits with 1 if any failed,   */
+/* 0 otherwise.                                                            */
+/***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+#include "library1.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+					#condition); \
+			failures++; \
+		} \
+	} while (0)
+
+static char dir[] = "checkpointTest.XXXXXX";
+
+/* Whether dir/name exists. */
+static bool Exists(const char *name) {
+	char path[PATH_MAX];
+	struct stat fileStat;
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	return stat(path, &fileStat) == 0;
+}
+
+/* The generation named by the CHECKPOINT file, 0 if there is none. */
+static long long Manifest() {
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/CHECKPOINT", dir);
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return 0;
+	}
+	long long generation = -1;
+	if (fscanf(file, "%lld", &generation) != 1) {
+		generation = -1;
+	}
+	fclose(file);
+	return generation;
+}
+
+/* The size of dir/name, -1 if it doesn't exist. */
+static long FileSize(const char *name) {
+	char path[PATH_MAX];
+	struct stat fileStat;
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	if (stat(path, &fileStat) != 0) {
+		return -1;
+	}
+	return fileStat.st_size;
+}
+
+/* Removes dir and every file in it. */
+static void RemoveDir() {
+	DIR *entries = opendir(dir);
+	if (entries == NULL) {
+		return;
+	}
+	struct dirent *entry;
+	char path[PATH_MAX];
+	while ((entry = readdir(entries)) != NULL) {
+		if (strcmp(entry->d_name, ".") != 0
+				&& strcmp(entry->d_name, "..") != 0) {
+			snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+			if (unlink(path) != 0) {
+				rmdir(path);
+			}
+		}
+	}
+	closedir(entries);
+	rmdir(dir);
+}
+
+/* Logs trainer trainerID and count pokemons of it through the checkpointer,
+ * and applies the same mutations to reference. */
+static void Mutate(Checkpointer *checkpointer, void *DS, void *reference,
+		int trainerID, int count) {
+	CHECK(WalAddTrainer(CheckpointWal(checkpointer), DS, trainerID) == SUCCESS);
+	CHECK(AddTrainer(reference, trainerID) == SUCCESS);
+	for (int i = 1; i <= count; i++) {
+		int pokemonID = trainerID * 100 + i;
+		CHECK(WalCatchPokemon(CheckpointWal(checkpointer), DS, pokemonID,
+				trainerID, i % 3 + 1) == SUCCESS);
+		CHECK(CatchPokemon(reference, pokemonID, trainerID, i % 3 + 1)
+				== SUCCESS);
+	}
+	CHECK(WalUpdateLevels(CheckpointWal(checkpointer), DS, 2, 3) == SUCCESS);
+	CHECK(UpdateLevels(reference, 2, 3) == SUCCESS);
+}
+
+/* Checks that two DSs hold the same pokemons in the same order. */
+static void CheckSameDS(void *DS, void *other) {
+	int *pokemons = NULL;
+	int numOfPokemons = -1;
+	int *otherPokemons = NULL;
+	int numOfOther = -2;
+	CHECK(GetAllPokemonsByLevel(DS, -1, &pokemons, &numOfPokemons) == SUCCESS);
+	CHECK(GetAllPokemonsByLevel(other, -1, &otherPokemons, &numOfOther)
+			== SUCCESS);
+	CHECK(numOfOther == numOfPokemons);
+	for (int i = 0; i < numOfPokemons && i < numOfOther; i++) {
+		CHECK(otherPokemons[i] == pokemons[i]);
+	}
+	free(pokemons);
+	free(otherPokemons);
+}
+
+/* Recovers the checkpoint directory into a new DS and checks it against
+ * reference. */
+static void CheckRecovery(void *reference) {
+	void *DS = NULL;
+	Checkpointer *checkpointer = CheckpointOpen(dir, 1, 0, &DS);
+	CHECK(checkpointer != NULL && DS != NULL);
+	if (checkpointer != NULL) {
+		CheckSameDS(reference, DS);
+	}
+	CheckpointClose(&checkpointer);
+	Quit(&DS);
+}
+
+static void TestInvalid() {
+	void *DS = NULL;
+	CHECK(CheckpointOpen(NULL, 1, 0, &DS) == NULL);
+	CHECK(CheckpointOpen(dir, 1, 0, NULL) == NULL);
+	CHECK(CheckpointOpen(dir, 0, 0, &DS) == NULL);
+	CHECK(DS == NULL);
+	CHECK(CheckpointWal(NULL) == NULL);
+	CHECK(CheckpointPoll(NULL, true) == INVALID_INPUT);
+	void *other = Init();
+	CHECK(CheckpointStart(NULL, other) == INVALID_INPUT);
+	Quit(&other);
+	CheckpointClose(NULL);
+
+	Checkpointer *checkpointer = CheckpointOpen(dir, 1, 0, &DS);
+	CHECK(checkpointer != NULL);
+	CHECK(CheckpointStart(checkpointer, NULL) == INVALID_INPUT);
+	// no running checkpoint
+	CHECK(CheckpointPoll(checkpointer, true) == SUCCESS);
+	CheckpointClose(&checkpointer);
+	CHECK(checkpointer == NULL);
+	Quit(&DS);
+}
+
+/* Generations are published one after the other, and every older one is
+ * deleted once a newer snapshot is published. */
+static void TestGenerations() {
+	void *DS = NULL;
+	void *reference = Init();
+	Checkpointer *checkpointer = CheckpointOpen(dir, 2, 0, &DS);
+	CHECK(checkpointer != NULL);
+	if (checkpointer == NULL) {
+		Quit(&reference);
+		return;
+	}
+	// an empty directory is generation 0 with no snapshot
+	CHECK(Exists("wal.0"));
+	CHECK(Manifest() == 0);
+	Mutate(checkpointer, DS, reference, 1, 5);
+
+	CHECK(CheckpointStart(checkpointer, DS) == SUCCESS);
+	CHECK(Exists("wal.1"));
+	// one checkpoint at a time
+	CHECK(CheckpointStart(checkpointer, DS) == FAILURE);
+	// the mutations after the start go to the new segment only
+	long oldSegment = FileSize("wal.0");
+	Mutate(checkpointer, DS, reference, 2, 4);
+	CHECK(FileSize("wal.0") == oldSegment);
+	CHECK(CheckpointPoll(checkpointer, true) == SUCCESS);
+	CHECK(Manifest() == 1);
+	CHECK(Exists("snapshot.1"));
+	CHECK(!Exists("wal.0"));
+
+	CHECK(CheckpointStart(checkpointer, DS) == SUCCESS);
+	Mutate(checkpointer, DS, reference, 3, 3);
+	CHECK(CheckpointPoll(checkpointer, true) == SUCCESS);
+	CHECK(Manifest() == 2);
+	CHECK(Exists("snapshot.2") && Exists("wal.2"));
+	CHECK(!Exists("snapshot.1") && !Exists("wal.1"));
+
+	Mutate(checkpointer, DS, reference, 4, 2);
+	CheckpointClose(&checkpointer);
+	CheckSameDS(reference, DS);
+	CheckRecovery(reference);
+	Quit(&DS);
+
+	// recovery cuts a torn tail of the newest segment: the last logged
+	// mutation, UpdateLevels(2, 3), is lost and trainer 4 keeps the levels
+	// its pokemons were caught with
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/wal.2", dir);
+	CHECK(truncate(path, FileSize("wal.2") - 1) == 0);
+	Quit(&reference);
+	reference = NULL;
+	Checkpointer *recovered = CheckpointOpen(dir, 1, 0, &DS);
+	CHECK(recovered != NULL);
+	int top = 0;
+	CHECK(GetTopPokemon(DS, 4, &top) == SUCCESS);
+	CHECK(top == 402);
+	int count = 0;
+	long long sum = 0;
+	int max = 0;
+	CHECK(GetTrainerStats(DS, 4, &count, &sum, &max) == SUCCESS);
+	CHECK(count == 2 && sum == 5 && max == 3);
+	CheckpointClose(&recovered);
+	Quit(&DS);
+}
+
+/* A checkpoint whose snapshot can't be written isn't published, and keeps
+ * every segment recovery needs. */
+static void TestFailedCheckpoint() {
+	RemoveDir();
+	CHECK(mkdir(dir, 0755) == 0);
+	void *DS = NULL;
+	void *reference = Init();
+	Checkpointer *checkpointer = CheckpointOpen(dir, 1, 0, &DS);
+	CHECK(checkpointer != NULL);
+	if (checkpointer == NULL) {
+		Quit(&reference);
+		return;
+	}
+	Mutate(checkpointer, DS, reference, 1, 4);
+	CHECK(CheckpointStart(checkpointer, DS) == SUCCESS);
+	CHECK(CheckpointPoll(checkpointer, true) == SUCCESS);
+	CHECK(Manifest() == 1);
+
+	// a non-empty directory in place of snapshot.2 fails its rename
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s/snapshot.2", dir);
+	CHECK(mkdir(path, 0755) == 0);
+	snprintf(path, sizeof(path), "%s/snapshot.2/keep", dir);
+	FILE *keep = fopen(path, "w");
+	CHECK(keep != NULL);
+	if (keep != NULL) {
+		fclose(keep);
+	}
+	Mutate(checkpointer, DS, reference, 2, 3);
+	CHECK(CheckpointStart(checkpointer, DS) == SUCCESS);
+	Mutate(checkpointer, DS, reference, 3, 2);
+	CHECK(CheckpointPoll(checkpointer, true) == FAILURE);
+	CHECK(Manifest() == 1);
+	CHECK(Exists("snapshot.1") && Exists("wal.1") && Exists("wal.2"));
+	CheckpointClose(&checkpointer);
+	unlink(path);
+	snprintf(path, sizeof(path), "%s/snapshot.2", dir);
+	rmdir(path);
+
+	// recovery replays snapshot.1, wal.1 and wal.2
+	CheckRecovery(reference);
+	Quit(&reference);
+	Quit(&DS);
+}
+
+int main() {
+	if (mkdtemp(dir) == NULL) {
+		fprintf(stderr, "checkpointTest: can't create %s\n", dir);
+		return 1;
+	}
+	TestInvalid();
+	RemoveDir();
+	CHECK(mkdir(dir, 0755) == 0);
+	TestGenerations();
+	TestFailedCheckpoint();
+	RemoveDir();
+	if (failures > 0) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	printf("checkpointTest: all checks passed\n");
+	return 0;
+}
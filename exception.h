@@ -0,0 +1,35 @@
+#ifndef EXCEPTION_H_
+#define EXCEPTION_H_
+#include <exception>
+
+namespace TreeExceptions {
+/**
+ * TreeException - base class of the errors thrown by AvlTree.
+ */
+class TreeException : public std::exception {
+};
+
+/**
+ * ElementNotFound - thrown when an operation is given an iterator that does
+ * not point to an element of the tree.
+ */
+class ElementNotFound : public TreeException {
+public:
+	const char* what() const noexcept override {
+		return "element not found";
+	}
+};
+}
+
+/**
+ * IllegealOperationException - thrown when an iterator is moved past the
+ * tree's end.
+ */
+class IllegealOperationException : public TreeExceptions::TreeException {
+public:
+	const char* what() const noexcept override {
+		return "illegal operation";
+	}
+};
+
+#endif /* EXCEPTION_H_ */
@@ -0,0 +1,382 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : frozenSnapshot.cpp                                          */
+/*                                                                         */
+/* Writing, mapping and querying of the frozen snapshot described in       */
+/* frozenSnapshot.h.                                                       */
+/***************************************************************************/
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "frozenSnapshot.h"
+
+static const int numOfSections = 9;
+
+/* Fills lengths with the number of int32 in every section, in the order of
+ * the offsets in FrozenHeader. */
+static void SectionLengths(uint64_t numOfTrainers, uint64_t numOfPokemons,
+		uint64_t *lengths) {
+	for (int i = 0; i < numOfSections; i++) {
+		lengths[i] = numOfPokemons;
+	}
+	lengths[5] = numOfTrainers; // trainerIDs
+	lengths[6] = numOfTrainers + 1; // trainerOffsets
+}
+
+/* Returns the index of value in the sorted array, or -1 if it isn't there. */
+static int FindSorted(const int32_t *array, int size, int value) {
+	int low = 0;
+	int high = size;
+	while (low < high) {
+		int middle = low + (high - low) / 2;
+		if (array[middle] < value) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return (low < size && array[low] == value) ? low : -1;
+}
+
+/* Returns the number of pokemons that come before (level, pokemonID) in the
+ * level ordered arrays ids/levels. */
+static int CountBefore(const int32_t *ids, const int32_t *levels, int size,
+		int level, int pokemonID) {
+	int low = 0;
+	int high = size;
+	while (low < high) {
+		int middle = low + (high - low) / 2;
+		if (levels[middle] > level
+				|| (levels[middle] == level && ids[middle] < pokemonID)) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+/***************************************************************************/
+/* FrozenWrite                                                             */
+/***************************************************************************/
+StatusType FrozenWrite(const char *path, const SnapshotData *data) {
+	if (path == NULL || data == NULL) {
+		return INVALID_INPUT;
+	}
+	int numOfTrainers = data->numOfTrainers;
+	int numOfPokemons = data->numOfPokemons;
+
+	// every section but trainerIDs and trainerOffsets is numOfPokemons long
+	int32_t *buffer = (int32_t*) malloc(
+			sizeof(int32_t) * ((size_t) 7 * numOfPokemons + 2 * numOfTrainers + 1));
+	int32_t *cursors = (int32_t*) malloc(
+			sizeof(int32_t) * ((size_t) numOfTrainers + 1));
+	if (buffer == NULL || cursors == NULL) {
+		free(buffer);
+		free(cursors);
+		return ALLOCATION_ERROR;
+	}
+	int32_t *ids = buffer;
+	int32_t *idTrainers = ids + numOfPokemons;
+	int32_t *idLevels = idTrainers + numOfPokemons;
+	int32_t *byLevel = idLevels + numOfPokemons;
+	int32_t *byLevelLevels = byLevel + numOfPokemons;
+	int32_t *trainerIDs = byLevelLevels + numOfPokemons;
+	int32_t *trainerOffsets = trainerIDs + numOfTrainers;
+	int32_t *trainerPokemons = trainerOffsets + numOfTrainers + 1;
+	int32_t *trainerLevels = trainerPokemons + numOfPokemons;
+
+	for (int i = 0; i < numOfPokemons; i++) {
+		ids[i] = data->pokemonsByID[i].pokemonID;
+		idTrainers[i] = data->pokemonsByID[i].trainerID;
+		idLevels[i] = data->pokemonsByID[i].level;
+		byLevel[i] = data->pokemonsByLevel[i].pokemonID;
+		byLevelLevels[i] = data->pokemonsByLevel[i].level;
+	}
+	for (int i = 0; i < numOfTrainers; i++) {
+		trainerIDs[i] = data->trainers[i].trainerID;
+		cursors[i] = 0;
+	}
+
+	// count the pokemons of every trainer, then place them in level order
+	bool valid = true;
+	for (int i = 0; i < numOfPokemons && valid; i++) {
+		int trainer = FindSorted(trainerIDs, numOfTrainers,
+				data->pokemonsByLevel[i].trainerID);
+		valid = trainer >= 0;
+		if (valid) {
+			cursors[trainer]++;
+		}
+	}
+	if (!valid) {
+		free(buffer);
+		free(cursors);
+		return FAILURE;
+	}
+	int offset = 0;
+	for (int i = 0; i < numOfTrainers; i++) {
+		trainerOffsets[i] = offset;
+		offset += cursors[i];
+		cursors[i] = trainerOffsets[i];
+	}
+	trainerOffsets[numOfTrainers] = offset;
+	for (int i = 0; i < numOfPokemons; i++) {
+		int trainer = FindSorted(trainerIDs, numOfTrainers,
+				data->pokemonsByLevel[i].trainerID);
+		trainerPokemons[cursors[trainer]] = byLevel[i];
+		trainerLevels[cursors[trainer]] = byLevelLevels[i];
+		cursors[trainer]++;
+	}
+	free(cursors);
+
+	const void *sections[numOfSections + 1];
+	size_t sizes[numOfSections + 1];
+	FrozenHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, FROZEN_MAGIC, sizeof(header.magic));
+	header.version = FROZEN_VERSION;
+	header.numOfTrainers = numOfTrainers;
+	header.numOfPokemons = numOfPokemons;
+	sections[0] = &header;
+	sizes[0] = sizeof(header);
+	uint64_t *offsets[numOfSections] = { &header.ids, &header.idTrainers,
+			&header.idLevels, &header.byLevel, &header.byLevelLevels,
+			&header.trainerIDs, &header.trainerOffsets, &header.trainerPokemons,
+			&header.trainerLevels };
+	const int32_t *arrays[numOfSections] = { ids, idTrainers, idLevels,
+			byLevel, byLevelLevels, trainerIDs, trainerOffsets, trainerPokemons,
+			trainerLevels };
+	uint64_t lengths[numOfSections];
+	SectionLengths(numOfTrainers, numOfPokemons, lengths);
+	uint64_t position = sizeof(header);
+	for (int i = 0; i < numOfSections; i++) {
+		*offsets[i] = position;
+		sections[i + 1] = arrays[i];
+		sizes[i + 1] = sizeof(int32_t) * lengths[i];
+		position += sizes[i + 1];
+	}
+	header.fileSize = position;
+
+	StatusType res = SnapshotWriteFile(path, sections, sizes,
+			numOfSections + 1);
+	free(buffer);
+	return res;
+}
+
+/***************************************************************************/
+/* FrozenOpen                                                              */
+/***************************************************************************/
+FrozenSnapshot* FrozenOpen(const char *path) {
+	if (path == NULL) {
+		return NULL;
+	}
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0
+			|| (size_t) fileStat.st_size < sizeof(FrozenHeader)) {
+		close(fd);
+		return NULL;
+	}
+	size_t size = fileStat.st_size;
+	void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return NULL;
+	}
+
+	const FrozenHeader *header = (const FrozenHeader*) mapping;
+	uint64_t numOfTrainers = header->numOfTrainers;
+	uint64_t numOfPokemons = header->numOfPokemons;
+	bool valid = memcmp(header->magic, FROZEN_MAGIC, sizeof(header->magic)) == 0
+			&& header->version == FROZEN_VERSION && header->numOfTrainers >= 0
+			&& header->numOfPokemons >= 0 && header->fileSize == size;
+	const uint64_t offsets[numOfSections] = { header->ids, header->idTrainers,
+			header->idLevels, header->byLevel, header->byLevelLevels,
+			header->trainerIDs, header->trainerOffsets, header->trainerPokemons,
+			header->trainerLevels };
+	uint64_t lengths[numOfSections];
+	SectionLengths(numOfTrainers, numOfPokemons, lengths);
+	for (int i = 0; i < numOfSections && valid; i++) {
+		valid = offsets[i] % sizeof(int32_t) == 0 && offsets[i] <= size
+				&& lengths[i] * sizeof(int32_t) <= size - offsets[i];
+	}
+	// the queries index trainerPokemons with trainerOffsets as they are, so
+	// every trainer's range must lie inside it
+	if (valid) {
+		const int32_t *trainerOffsets = (const int32_t*) ((const char*) mapping
+				+ header->trainerOffsets);
+		valid = trainerOffsets[0] == 0
+				&& trainerOffsets[numOfTrainers] == (int32_t) numOfPokemons;
+		for (uint64_t i = 0; i < numOfTrainers && valid; i++) {
+			valid = trainerOffsets[i] <= trainerOffsets[i + 1];
+		}
+	}
+	FrozenSnapshot *snapshot = valid ?
+			(FrozenSnapshot*) malloc(sizeof(FrozenSnapshot)) : NULL;
+	if (snapshot == NULL) {
+		munmap(mapping, size);
+		return NULL;
+	}
+
+	const char *base = (const char*) mapping;
+	snapshot->mapping = mapping;
+	snapshot->mappingSize = size;
+	snapshot->numOfTrainers = header->numOfTrainers;
+	snapshot->numOfPokemons = header->numOfPokemons;
+	snapshot->ids = (const int32_t*) (base + header->ids);
+	snapshot->idTrainers = (const int32_t*) (base + header->idTrainers);
+	snapshot->idLevels = (const int32_t*) (base + header->idLevels);
+	snapshot->byLevel = (const int32_t*) (base + header->byLevel);
+	snapshot->byLevelLevels = (const int32_t*) (base + header->byLevelLevels);
+	snapshot->trainerIDs = (const int32_t*) (base + header->trainerIDs);
+	snapshot->trainerOffsets = (const int32_t*) (base + header->trainerOffsets);
+	snapshot->trainerPokemons =
+			(const int32_t*) (base + header->trainerPokemons);
+	snapshot->trainerLevels = (const int32_t*) (base + header->trainerLevels);
+	return snapshot;
+}
+
+/***************************************************************************/
+/* FrozenClose                                                             */
+/***************************************************************************/
+void FrozenClose(FrozenSnapshot **snapshot) {
+	if (snapshot == NULL || *snapshot == NULL) {
+		return;
+	}
+	munmap((*snapshot)->mapping, (*snapshot)->mappingSize);
+	free(*snapshot);
+	*snapshot = NULL;
+}
+
+/***************************************************************************/
+/* Queries                                                                 */
+/***************************************************************************/
+StatusType FrozenGetTopPokemon(const FrozenSnapshot *snapshot, int trainerID,
+		int *pokemonID) {
+	const int32_t *pokemons;
+	int numOfPokemon;
+	if (pokemonID == NULL) {
+		return INVALID_INPUT;
+	}
+	StatusType res = FrozenGetAllPokemonsByLevel(snapshot, trainerID,
+			&pokemons, &numOfPokemon);
+	if (res != SUCCESS) {
+		return res;
+	}
+	*pokemonID = (numOfPokemon > 0) ? pokemons[0] : -1;
+	return SUCCESS;
+}
+
+StatusType FrozenGetAllPokemonsByLevel(const FrozenSnapshot *snapshot,
+		int trainerID, const int32_t **pokemons, int *numOfPokemon) {
+	if (snapshot == NULL || pokemons == NULL || numOfPokemon == NULL
+			|| trainerID == 0) {
+		return INVALID_INPUT;
+	}
+	if (trainerID < 0) {
+		*pokemons = snapshot->byLevel;
+		*numOfPokemon = snapshot->numOfPokemons;
+		return SUCCESS;
+	}
+	int trainer = FindSorted(snapshot->trainerIDs, snapshot->numOfTrainers,
+			trainerID);
+	if (trainer < 0) {
+		return FAILURE;
+	}
+	int begin = snapshot->trainerOffsets[trainer];
+	*pokemons = snapshot->trainerPokemons + begin;
+	*numOfPokemon = snapshot->trainerOffsets[trainer + 1] - begin;
+	return SUCCESS;
+}
+
+StatusType FrozenGetPokemon(const FrozenSnapshot *snapshot, int pokemonID,
+		int *trainerID, int *level) {
+	if (snapshot == NULL || trainerID == NULL || level == NULL
+			|| pokemonID <= 0) {
+		return INVALID_INPUT;
+	}
+	int index = FindSorted(snapshot->ids, snapshot->numOfPokemons, pokemonID);
+	if (index < 0) {
+		return FAILURE;
+	}
+	*trainerID = snapshot->idTrainers[index];
+	*level = snapshot->idLevels[index];
+	return SUCCESS;
+}
+
+StatusType FrozenGetRank(const FrozenSnapshot *snapshot, int trainerID,
+		int pokemonID, int *rank) {
+	int pokemonTrainer;
+	int level;
+	if (rank == NULL || trainerID == 0) {
+		return INVALID_INPUT;
+	}
+	StatusType res = FrozenGetPokemon(snapshot, pokemonID, &pokemonTrainer,
+			&level);
+	if (res != SUCCESS) {
+		return res;
+	}
+	if (trainerID < 0) {
+		*rank = 1 + CountBefore(snapshot->byLevel, snapshot->byLevelLevels,
+				snapshot->numOfPokemons, level, pokemonID);
+		return SUCCESS;
+	}
+	int trainer = FindSorted(snapshot->trainerIDs, snapshot->numOfTrainers,
+			trainerID);
+	if (trainer < 0 || pokemonTrainer != trainerID) {
+		return FAILURE;
+	}
+	int begin = snapshot->trainerOffsets[trainer];
+	int size = snapshot->trainerOffsets[trainer + 1] - begin;
+	*rank = 1 + CountBefore(snapshot->trainerPokemons + begin,
+			snapshot->trainerLevels + begin, size, level, pokemonID);
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* FrozenToSnapshotData                                                    */
+/***************************************************************************/
+StatusType FrozenToSnapshotData(const FrozenSnapshot *snapshot,
+		SnapshotData *data) {
+	if (snapshot == NULL || data == NULL) {
+		return INVALID_INPUT;
+	}
+	size_t numOfTrainers = snapshot->numOfTrainers;
+	size_t numOfPokemons = snapshot->numOfPokemons;
+	memset(data, 0, sizeof(*data));
+	data->numOfTrainers = snapshot->numOfTrainers;
+	data->numOfPokemons = snapshot->numOfPokemons;
+	data->trainers = (TrainerRecord*) malloc(
+			sizeof(TrainerRecord) * (numOfTrainers + 1));
+	data->pokemonsByID = (PokemonRecord*) malloc(
+			sizeof(PokemonRecord) * (numOfPokemons + 1));
+	data->pokemonsByLevel = (PokemonRecord*) malloc(
+			sizeof(PokemonRecord) * (numOfPokemons + 1));
+	if (data->trainers == NULL || data->pokemonsByID == NULL
+			|| data->pokemonsByLevel == NULL) {
+		SnapshotFree(data);
+		return ALLOCATION_ERROR;
+	}
+	for (size_t i = 0; i < numOfTrainers; i++) {
+		data->trainers[i].trainerID = snapshot->trainerIDs[i];
+	}
+	for (size_t i = 0; i < numOfPokemons; i++) {
+		data->pokemonsByID[i].pokemonID = snapshot->ids[i];
+		data->pokemonsByID[i].trainerID = snapshot->idTrainers[i];
+		data->pokemonsByID[i].level = snapshot->idLevels[i];
+		int index = FindSorted(snapshot->ids, snapshot->numOfPokemons,
+				snapshot->byLevel[i]);
+		data->pokemonsByLevel[i].pokemonID = snapshot->byLevel[i];
+		data->pokemonsByLevel[i].trainerID =
+				(index >= 0) ? snapshot->idTrainers[index] : 0;
+		data->pokemonsByLevel[i].level = snapshot->byLevelLevels[i];
+	}
+	return SUCCESS;
+}
@@ -0,0 +1,156 @@
+#ifndef FROZENSNAPSHOT_H_
+#define FROZENSNAPSHOT_H_
+#include <stdint.h>
+#include "library1.h"
+#include "snapshot.h"
+
+/*
+ * Frozen snapshot - a read-only snapshot of the DS laid out so it can be
+ * mmap-ed and queried in place, with no parsing and no copying on startup.
+ *
+ * The file is a FrozenHeader followed by the sections below, each an array of
+ * int32 starting at the offset recorded in the header:
+ *   ids, idTrainers, idLevels       - every pokemon, sorted by ID.
+ *   byLevel, byLevelLevels          - every pokemon in level order.
+ *   trainerIDs                      - every trainer, sorted by ID.
+ *   trainerOffsets                  - numOfTrainers + 1 entries; the pokemons
+ *                                     of trainerIDs[i] are entries
+ *                                     trainerOffsets[i]..trainerOffsets[i+1]-1
+ *                                     of the two sections below.
+ *   trainerPokemons, trainerLevels  - the pokemons of every trainer in level
+ *                                     order, grouped by trainer.
+ * Level order is the order of GetAllPokemonsByLevel: higher level first,
+ * pokemons with the same level by ascending ID.
+ *
+ * A frozen snapshot can't be changed. To mutate it, thaw it into a regular
+ * DS with Thaw (see library1.h).
+ */
+
+#define FROZEN_MAGIC   "PKMNFRZN"
+#define FROZEN_VERSION (1)
+
+typedef struct {
+	char magic[8];
+	int32_t version;
+	int32_t numOfTrainers;
+	int32_t numOfPokemons;
+	int32_t reserved;
+	uint64_t ids;
+	uint64_t idTrainers;
+	uint64_t idLevels;
+	uint64_t byLevel;
+	uint64_t byLevelLevels;
+	uint64_t trainerIDs;
+	uint64_t trainerOffsets;
+	uint64_t trainerPokemons;
+	uint64_t trainerLevels;
+	uint64_t fileSize;
+} FrozenHeader;
+
+/* An open frozen snapshot. The arrays point into the read-only mapping. */
+struct FrozenSnapshot {
+	void *mapping;
+	size_t mappingSize;
+	int numOfTrainers;
+	int numOfPokemons;
+	const int32_t *ids;
+	const int32_t *idTrainers;
+	const int32_t *idLevels;
+	const int32_t *byLevel;
+	const int32_t *byLevelLevels;
+	const int32_t *trainerIDs;
+	const int32_t *trainerOffsets;
+	const int32_t *trainerPokemons;
+	const int32_t *trainerLevels;
+};
+
+/* Description:   Writes a frozen snapshot file from the sections of a regular
+ *                snapshot (see snapshot.h), replacing path only once complete.
+ *                To freeze a DS, use FrozenSave (see library1.h).
+ * Input:         path - The file to write.
+ *                data - The sections, sorted as described in snapshot.h.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If any of the arguments is NULL.
+ *                FAILURE - If writing the file failed.
+ *                SUCCESS - Otherwise.
+ */
+StatusType FrozenWrite(const char *path, const SnapshotData *data);
+
+/* Description:   Maps a frozen snapshot file for querying. The header is
+ *                checked to place every section inside the file, and
+ *                trainerOffsets to start at 0, never decrease and end at
+ *                numOfPokemons, in O(numOfTrainers). The contents of the
+ *                other sections aren't checked.
+ * Input:         path - The file to map.
+ * Output:        None.
+ * Return Values: The open snapshot, or NULL if path==NULL, the file isn't a
+ *                valid frozen snapshot, or in case of an allocation error.
+ */
+FrozenSnapshot* FrozenOpen(const char *path);
+
+/* Description:   Unmaps a frozen snapshot. snapshot should be set to NULL.
+ * Input:         snapshot - A pointer to the open snapshot.
+ * Output:        None.
+ * Return Values: None.
+ */
+void FrozenClose(FrozenSnapshot **snapshot);
+
+/* Description:   The frozen version of GetTopPokemon.
+ *                If trainerID < 0, returns the top pokemon in the entire snapshot.
+ * Output:        pokemonID - Updated to the ID of the top pokemon, or to -1 if
+ *                there are no pokemons.
+ * Return Values: INVALID_INPUT - If snapshot==NULL, or if pokemonID == NULL, or if trainerID == 0.
+ *                FAILURE - If trainerID isn't in the snapshot.
+ *                SUCCESS - Otherwise.
+ */
+StatusType FrozenGetTopPokemon(const FrozenSnapshot *snapshot, int trainerID,
+		int *pokemonID);
+
+/* Description:   The frozen version of GetAllPokemonsByLevel. No array is
+ *                allocated - pokemons points into the mapping and stays valid
+ *                until FrozenClose.
+ *                If trainerID < 0, returns all the pokemons in the snapshot.
+ * Output:        pokemons - Updated to the pokemons' IDs in level order.
+ *                numOfPokemon - Updated to the number of pokemons.
+ * Return Values: INVALID_INPUT - If any of the arguments is NULL or if trainerID == 0.
+ *                FAILURE - If trainerID isn't in the snapshot.
+ *                SUCCESS - Otherwise.
+ */
+StatusType FrozenGetAllPokemonsByLevel(const FrozenSnapshot *snapshot,
+		int trainerID, const int32_t **pokemons, int *numOfPokemon);
+
+/* Description:   Returns the level and trainer of a pokemon.
+ * Output:        trainerID - Updated to the pokemon's trainer.
+ *                level - Updated to the pokemon's level.
+ * Return Values: INVALID_INPUT - If any of the arguments is NULL or if pokemonID <= 0.
+ *                FAILURE - If pokemonID isn't in the snapshot.
+ *                SUCCESS - Otherwise.
+ */
+StatusType FrozenGetPokemon(const FrozenSnapshot *snapshot, int pokemonID,
+		int *trainerID, int *level);
+
+/* Description:   Returns the position of a pokemon in level order, in
+ *                O(log n). If trainerID < 0 the position is among all the
+ *                pokemons of the snapshot, otherwise among the pokemons of
+ *                trainerID.
+ * Output:        rank - Updated to the position of the pokemon, 1 for the top pokemon.
+ * Return Values: INVALID_INPUT - If any of the arguments is NULL, or if trainerID == 0, or if pokemonID <= 0.
+ *                FAILURE - If pokemonID or trainerID aren't in the snapshot,
+ *                or if pokemonID doesn't belong to trainerID.
+ *                SUCCESS - Otherwise.
+ */
+StatusType FrozenGetRank(const FrozenSnapshot *snapshot, int trainerID,
+		int pokemonID, int *rank);
+
+/* Description:   Copies the contents of a frozen snapshot back into the
+ *                sections of a regular snapshot, as needed to thaw it.
+ * Output:        data - Updated with the sections, released by SnapshotFree.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If any of the arguments is NULL.
+ *                SUCCESS - Otherwise.
+ */
+StatusType FrozenToSnapshotData(const FrozenSnapshot *snapshot,
+		SnapshotData *data);
+
+#endif /* FROZENSNAPSHOT_H_ */
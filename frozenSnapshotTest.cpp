@@ -0,0 +1,313 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : frozenSnapshotTest.cpp                                      */
+/*                                                                         */
+/* Tests of the frozen snapshot described in frozenSnapshot.h: a DS saved */
+/* with FrozenSave answers the same queries in place and thaws back into  */
+/* an equal DS, and FrozenOpen rejects files whose header or              */
+/* trainerOffsets would send the queries outside the mapping.             */
+/*                                                                         */
+/* Usage: frozenSnapshotTest                                               */
+/*                                                                         */
+/* Built from frozenSnapshotTest.cpp and library1.cpp with its            */
+/* dependencies. Prints every failed check and exits with 1 if any        */
+/* failed, 0 otherwise.                                                    */
+/***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "frozenSnapshot.h"
+#include "library1.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+					#condition); \
+			failures++; \
+		} \
+	} while (0)
+
+static const char *path = "frozenSnapshotTest.frozen";
+
+/* The trainers of the test DS; 4 has no pokemons. */
+static const int trainerIDs[] = { 1, 2, 4 };
+static const int numOfTrainerIDs = 3;
+
+/* A DS with every trainer of trainerIDs, levels with ties and a mutation of
+ * every kind behind it. */
+static void* MakeDS() {
+	void *DS = Init();
+	if (DS == NULL) {
+		return NULL;
+	}
+	for (int i = 0; i < numOfTrainerIDs; i++) {
+		CHECK(AddTrainer(DS, trainerIDs[i]) == SUCCESS);
+	}
+	CHECK(CatchPokemon(DS, 10, 1, 5) == SUCCESS);
+	CHECK(CatchPokemon(DS, 11, 1, 5) == SUCCESS);
+	CHECK(CatchPokemon(DS, 12, 1, 9) == SUCCESS);
+	CHECK(CatchPokemon(DS, 20, 2, 7) == SUCCESS);
+	CHECK(CatchPokemon(DS, 21, 2, 1) == SUCCESS);
+	CHECK(CatchPokemon(DS, 22, 2, 3) == SUCCESS);
+	CHECK(LevelUp(DS, 21, 4) == SUCCESS);
+	CHECK(EvolvePokemon(DS, 22, 30) == SUCCESS);
+	CHECK(FreePokemon(DS, 11) == SUCCESS);
+	CHECK(UpdateLevels(DS, 10, 2) == SUCCESS);
+	return DS;
+}
+
+/* Checks that the level order of trainerID is the same in DS and snapshot. */
+static void CheckSameLevels(void *DS, const FrozenSnapshot *snapshot,
+		int trainerID) {
+	int *pokemons = NULL;
+	int numOfPokemons = -1;
+	CHECK(GetAllPokemonsByLevel(DS, trainerID, &pokemons, &numOfPokemons)
+			== SUCCESS);
+	const int32_t *frozen = NULL;
+	int numOfFrozen = -1;
+	CHECK(FrozenGetAllPokemonsByLevel(snapshot, trainerID, &frozen,
+			&numOfFrozen) == SUCCESS);
+	CHECK(numOfFrozen == numOfPokemons);
+	for (int i = 0; i < numOfPokemons && i < numOfFrozen; i++) {
+		CHECK(frozen[i] == pokemons[i]);
+		int rank = -1;
+		CHECK(FrozenGetRank(snapshot, trainerID, pokemons[i], &rank)
+				== SUCCESS);
+		CHECK(rank == i + 1);
+	}
+	int top = 0;
+	int frozenTop = 0;
+	CHECK(GetTopPokemon(DS, trainerID, &top) == SUCCESS);
+	CHECK(FrozenGetTopPokemon(snapshot, trainerID, &frozenTop) == SUCCESS);
+	CHECK(frozenTop == top);
+	free(pokemons);
+}
+
+/* Checks that two DSs hold the same pokemons in the same order. */
+static void CheckSameDS(void *DS, void *other, int trainerID) {
+	int *pokemons = NULL;
+	int numOfPokemons = -1;
+	int *otherPokemons = NULL;
+	int numOfOther = -2;
+	CHECK(GetAllPokemonsByLevel(DS, trainerID, &pokemons, &numOfPokemons)
+			== SUCCESS);
+	CHECK(GetAllPokemonsByLevel(other, trainerID, &otherPokemons, &numOfOther)
+			== SUCCESS);
+	CHECK(numOfOther == numOfPokemons);
+	for (int i = 0; i < numOfPokemons && i < numOfOther; i++) {
+		CHECK(otherPokemons[i] == pokemons[i]);
+	}
+	int count = 0, otherCount = -1;
+	long long sum = 0, otherSum = -1;
+	int max = 0, otherMax = -1;
+	CHECK(GetTrainerStats(DS, trainerID, &count, &sum, &max) == SUCCESS);
+	CHECK(GetTrainerStats(other, trainerID, &otherCount, &otherSum, &otherMax)
+			== SUCCESS);
+	CHECK(count == otherCount && sum == otherSum && max == otherMax);
+	free(pokemons);
+	free(otherPokemons);
+}
+
+static void TestInvalid() {
+	void *DS = Init();
+	CHECK(FrozenSave(NULL, path) == INVALID_INPUT);
+	CHECK(FrozenSave(DS, NULL) == INVALID_INPUT);
+	CHECK(FrozenOpen(NULL) == NULL);
+	CHECK(Thaw(NULL) == NULL);
+	unlink(path);
+	CHECK(FrozenOpen(path) == NULL);
+	Quit(&DS);
+}
+
+/* DS -> FrozenSave -> FrozenOpen -> queries and Thaw. */
+static void TestRoundTrip() {
+	void *DS = MakeDS();
+	CHECK(DS != NULL);
+	if (DS == NULL) {
+		return;
+	}
+	CHECK(FrozenSave(DS, path) == SUCCESS);
+	FrozenSnapshot *snapshot = FrozenOpen(path);
+	CHECK(snapshot != NULL);
+	if (snapshot == NULL) {
+		Quit(&DS);
+		return;
+	}
+	CHECK(snapshot->numOfTrainers == numOfTrainerIDs);
+	CHECK(snapshot->numOfPokemons == 5);
+	CheckSameLevels(DS, snapshot, -1);
+	for (int i = 0; i < numOfTrainerIDs; i++) {
+		CheckSameLevels(DS, snapshot, trainerIDs[i]);
+	}
+	int trainerID = 0;
+	int level = 0;
+	CHECK(FrozenGetPokemon(snapshot, 30, &trainerID, &level) == SUCCESS);
+	CHECK(trainerID == 2 && level == 6);
+	CHECK(FrozenGetPokemon(snapshot, 11, &trainerID, &level) == FAILURE);
+	int top = 0;
+	CHECK(FrozenGetTopPokemon(snapshot, 3, &top) == FAILURE);
+	CHECK(FrozenGetTopPokemon(snapshot, 4, &top) == SUCCESS);
+	CHECK(top == -1);
+
+	void *thawed = Thaw(snapshot);
+	FrozenClose(&snapshot);
+	CHECK(snapshot == NULL);
+	CHECK(thawed != NULL);
+	if (thawed != NULL) {
+		CheckSameDS(DS, thawed, -1);
+		for (int i = 0; i < numOfTrainerIDs; i++) {
+			CheckSameDS(DS, thawed, trainerIDs[i]);
+		}
+		// the thawed DS is a regular, mutable one
+		CHECK(CatchPokemon(thawed, 40, 4, 100) == SUCCESS);
+		CHECK(GetTopPokemon(thawed, -1, &top) == SUCCESS);
+		CHECK(top == 40);
+		CHECK(GetTopPokemon(DS, -1, &top) == SUCCESS);
+		CHECK(top != 40);
+		Quit(&thawed);
+	}
+
+	// an empty DS round trips too
+	void *empty = Init();
+	CHECK(FrozenSave(empty, path) == SUCCESS);
+	snapshot = FrozenOpen(path);
+	CHECK(snapshot != NULL);
+	if (snapshot != NULL) {
+		CHECK(FrozenGetTopPokemon(snapshot, -1, &top) == SUCCESS);
+		CHECK(top == -1);
+		void *thawedEmpty = Thaw(snapshot);
+		CHECK(thawedEmpty != NULL);
+		Quit(&thawedEmpty);
+		FrozenClose(&snapshot);
+	}
+	Quit(&empty);
+	Quit(&DS);
+	unlink(path);
+}
+
+/* Reads the whole file at path. NULL if it can't be read. */
+static char* ReadFile(size_t *size) {
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	*size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char *bytes = (char*) malloc(*size);
+	if (bytes != NULL && fread(bytes, 1, *size, file) != *size) {
+		free(bytes);
+		bytes = NULL;
+	}
+	fclose(file);
+	return bytes;
+}
+
+static void WriteFile(const char *bytes, size_t size) {
+	FILE *file = fopen(path, "wb");
+	CHECK(file != NULL);
+	if (file != NULL) {
+		CHECK(fwrite(bytes, 1, size, file) == size);
+		fclose(file);
+	}
+}
+
+/* Writes the saved file with trainerOffsets[index] set to value, and
+ * returns whether FrozenOpen accepts it. */
+static bool OpensWithOffset(const char *saved, size_t size, int index,
+		int32_t value) {
+	char *bytes = (char*) malloc(size);
+	memcpy(bytes, saved, size);
+	const FrozenHeader *header = (const FrozenHeader*) bytes;
+	int32_t *trainerOffsets = (int32_t*) (bytes + header->trainerOffsets);
+	trainerOffsets[index] = value;
+	WriteFile(bytes, size);
+	free(bytes);
+	FrozenSnapshot *snapshot = FrozenOpen(path);
+	if (snapshot == NULL) {
+		return false;
+	}
+	FrozenClose(&snapshot);
+	return true;
+}
+
+static void TestCorrupted() {
+	void *DS = MakeDS();
+	CHECK(DS != NULL && FrozenSave(DS, path) == SUCCESS);
+	Quit(&DS);
+	size_t size = 0;
+	char *saved = ReadFile(&size);
+	CHECK(saved != NULL);
+	if (saved == NULL) {
+		return;
+	}
+	const FrozenHeader *header = (const FrozenHeader*) saved;
+	int numOfTrainers = header->numOfTrainers;
+	int numOfPokemons = header->numOfPokemons;
+	const int32_t *trainerOffsets =
+			(const int32_t*) (saved + header->trainerOffsets);
+
+	// trainerOffsets: start at 0, never decrease, end at numOfPokemons
+	CHECK(!OpensWithOffset(saved, size, 0, 1));
+	CHECK(!OpensWithOffset(saved, size, numOfTrainers, numOfPokemons + 1));
+	CHECK(!OpensWithOffset(saved, size, numOfTrainers, numOfPokemons - 1));
+	CHECK(!OpensWithOffset(saved, size, 1, trainerOffsets[2] + 1));
+	CHECK(!OpensWithOffset(saved, size, 1, -1));
+	CHECK(OpensWithOffset(saved, size, 1, trainerOffsets[1]));
+
+	// the header has to describe the file
+	char *bytes = (char*) malloc(size);
+	memcpy(bytes, saved, size);
+	bytes[0] = 'X';
+	WriteFile(bytes, size);
+	CHECK(FrozenOpen(path) == NULL);
+	memcpy(bytes, saved, size);
+	((FrozenHeader*) bytes)->version = FROZEN_VERSION + 1;
+	WriteFile(bytes, size);
+	CHECK(FrozenOpen(path) == NULL);
+	memcpy(bytes, saved, size);
+	((FrozenHeader*) bytes)->trainerLevels = size;
+	WriteFile(bytes, size);
+	CHECK(FrozenOpen(path) == NULL);
+	memcpy(bytes, saved, size);
+	((FrozenHeader*) bytes)->ids = 2;
+	WriteFile(bytes, size);
+	CHECK(FrozenOpen(path) == NULL);
+	WriteFile(saved, size - sizeof(int32_t));
+	CHECK(FrozenOpen(path) == NULL);
+	WriteFile(saved, sizeof(FrozenHeader) - 1);
+	CHECK(FrozenOpen(path) == NULL);
+
+	// FrozenOpen checks only the layout; Thaw rejects bad contents
+	memcpy(bytes, saved, size);
+	int32_t *ids = (int32_t*) (bytes + ((FrozenHeader*) bytes)->ids);
+	int32_t first = ids[0];
+	ids[0] = ids[1];
+	ids[1] = first;
+	WriteFile(bytes, size);
+	FrozenSnapshot *snapshot = FrozenOpen(path);
+	CHECK(snapshot != NULL);
+	CHECK(Thaw(snapshot) == NULL);
+	FrozenClose(&snapshot);
+
+	free(bytes);
+	free(saved);
+	unlink(path);
+}
+
+int main() {
+	TestInvalid();
+	TestRoundTrip();
+	TestCorrupted();
+	if (failures > 0) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	printf("frozenSnapshotTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,88 @@
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Latency histogram in the style of HdrHistogram: values below
+ * HISTOGRAM_SUB_BUCKETS are counted exactly, and every power of two range
+ * above is split into HISTOGRAM_SUB_BUCKETS equal buckets, so any recorded
+ * value is reported within 1/HISTOGRAM_SUB_BUCKETS (under 2%) of itself,
+ * from a few ticks up to 2^64, at a fixed cost of one count per value.
+ */
+
+#define HISTOGRAM_SUB_BUCKET_BITS (6)
+#define HISTOGRAM_SUB_BUCKETS     (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKETS \
+	(HISTOGRAM_SUB_BUCKETS * (64 - HISTOGRAM_SUB_BUCKET_BITS + 1))
+
+typedef struct {
+	uint64_t counts[HISTOGRAM_BUCKETS];
+	uint64_t totalCount;
+	uint64_t maxValue;
+} LatencyHistogram;
+
+static inline void HistogramReset(LatencyHistogram *histogram) {
+	memset(histogram, 0, sizeof(*histogram));
+}
+
+static inline int HistogramBucket(uint64_t value) {
+	if (value < HISTOGRAM_SUB_BUCKETS) {
+		return (int) value;
+	}
+	int exponent = 63 - __builtin_clzll(value);
+	int shift = exponent - HISTOGRAM_SUB_BUCKET_BITS;
+	int subBucket = (int) (value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1);
+	return HISTOGRAM_SUB_BUCKETS * (shift + 1) + subBucket;
+}
+
+/* The highest value counted in a bucket */
+static inline uint64_t HistogramBucketValue(int bucket) {
+	if (bucket < HISTOGRAM_SUB_BUCKETS) {
+		return (uint64_t) bucket;
+	}
+	int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+	uint64_t subBucket = (uint64_t) (bucket % HISTOGRAM_SUB_BUCKETS);
+	uint64_t lowest = (HISTOGRAM_SUB_BUCKETS + subBucket) << shift;
+	return lowest + ((uint64_t) 1 << shift) - 1;
+}
+
+static inline void HistogramRecord(LatencyHistogram *histogram,
+		uint64_t value) {
+	histogram->counts[HistogramBucket(value)]++;
+	histogram->totalCount++;
+	if (value > histogram->maxValue) {
+		histogram->maxValue = value;
+	}
+}
+
+/* Description:   The value at a percentile of the recorded values.
+ * Input:         histogram - The histogram.
+ *                percentile - The percentile, between 0 and 100.
+ * Output:        None.
+ * Return Values: The highest value of the bucket holding the percentile,
+ *                never more than the highest value recorded. 0 if nothing
+ *                was recorded.
+ */
+static inline uint64_t HistogramPercentile(const LatencyHistogram *histogram,
+		double percentile) {
+	if (histogram->totalCount == 0) {
+		return 0;
+	}
+	uint64_t rank = (uint64_t) (percentile / 100.0 * histogram->totalCount
+			+ 0.5);
+	if (rank < 1) {
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) {
+		seen += histogram->counts[bucket];
+		if (seen >= rank) {
+			uint64_t value = HistogramBucketValue(bucket);
+			return value < histogram->maxValue ? value : histogram->maxValue;
+		}
+	}
+	return histogram->maxValue;
+}
+
+#endif /* LATENCYHISTOGRAM_H_ */
@@ -0,0 +1,736 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : library1.cpp                                                */
+/*                                                                         */
+/* The data structure behind the interface of library1.h.                  */
+/*                                                                         */
+/* Pokemons are kept in an ID index and in a level index, and every       */
+/* trainer, kept in a trainer index, has a level index of his own. Every  */
+/* index keeps a reserve of tree nodes (see AvlTree::reserve): a mutation */
+/* first reserves every node it needs, in all the indexes it changes, and */
+/* only then changes them, so an allocation error leaves the DS as it    */
+/* was. A mutation that removes and re-adds a pokemon reuses the removed  */
+/* node and needs no reserve at all.                                       */
+/***************************************************************************/
+
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include "library1.h"
+#include "avlTree.h"
+#include "changeFeed.h"
+#include "frozenSnapshot.h"
+#include "pokemon.h"
+#include "snapshot.h"
+#include "topWatch.h"
+#include "trainer.h"
+
+struct DataStructure {
+	AvlTree<Trainer> trainers;
+	AvlTree<Pokemon> pokemons;
+	LevelIndex pokemonsByLevel;
+	// the statistics of all the pokemons, as a trainer keeps his own
+	TrainerStats stats;
+	ChangeFeed *feed;
+	TopWatch *watch;
+
+	DataStructure() :
+			feed(NULL), watch(NULL) {
+	}
+};
+
+static Trainer* FindTrainer(DataStructure *ds, int trainerID) {
+	return ds->trainers.search(Trainer(trainerID)).get();
+}
+
+static Pokemon* FindPokemon(DataStructure *ds, int pokemonID) {
+	return ds->pokemons.search(Pokemon(pokemonID)).get();
+}
+
+/* Emits the event of a successful mutation to the DS's feed, if it has one. */
+static void Emit(DataStructure *ds, FeedEventType type, int numOfArgs,
+		int arg0, int arg1 = 0, int arg2 = 0) {
+	if (ds->feed == NULL) {
+		return;
+	}
+	FeedEvent event;
+	event.type = type;
+	event.numOfArgs = numOfArgs;
+	event.args[0] = arg0;
+	event.args[1] = arg1;
+	event.args[2] = arg2;
+	ChangeFeedEmit(ds->feed, &event);
+}
+
+/* Notifies the DS's watch, if it has one, that a mutation changed the top
+ * pokemon of trainerID (-1 for the whole DS) from oldTop to newTop. */
+static void NotifyTop(DataStructure *ds, int trainerID, int oldTop,
+		int newTop) {
+	if (ds->watch != NULL && newTop != oldTop) {
+		TopWatchNotify(ds->watch, trainerID, newTop);
+	}
+}
+
+/* NotifyTop for the two top pokemons a mutation of one trainer touches: the
+ * trainer's and the whole DS's, which were oldTop and oldGlobalTop. */
+static void NotifyTops(DataStructure *ds, Trainer *trainer, int oldTop,
+		int oldGlobalTop) {
+	NotifyTop(ds, trainer->getID(), oldTop, trainer->getPokemons().top());
+	NotifyTop(ds, -1, oldGlobalTop, ds->pokemonsByLevel.top());
+}
+
+/* The level index a query reads: the whole DS's if trainerID < 0. NULL if
+ * the trainer isn't in the DS. */
+static LevelIndex* QueriedIndex(DataStructure *ds, int trainerID) {
+	if (trainerID < 0) {
+		return &ds->pokemonsByLevel;
+	}
+	Trainer *trainer = FindTrainer(ds, trainerID);
+	return (trainer == NULL) ? NULL : &trainer->getPokemons();
+}
+
+/***************************************************************************/
+/* Init                                                                    */
+/***************************************************************************/
+void* Init() {
+	return new (std::nothrow) DataStructure();
+}
+
+/***************************************************************************/
+/* ReserveCapacity                                                         */
+/***************************************************************************/
+StatusType ReserveCapacity(void *DS, int numOfTrainers, int numOfPokemons) {
+	if (DS == NULL || numOfTrainers < 0 || numOfPokemons < 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	if (!ds->trainers.reserve(numOfTrainers)
+			|| !ds->pokemons.reserve(numOfPokemons)
+			|| !ds->pokemonsByLevel.reserve(numOfPokemons)) {
+		return ALLOCATION_ERROR;
+	}
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* AddTrainer                                                              */
+/***************************************************************************/
+StatusType AddTrainer(void *DS, int trainerID) {
+	if (DS == NULL || trainerID <= 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	if (FindTrainer(ds, trainerID) != NULL) {
+		return FAILURE;
+	}
+	if (!ds->trainers.reserve(1)) {
+		return ALLOCATION_ERROR;
+	}
+	ds->trainers.tryInsert(Trainer(trainerID));
+	Emit(ds, FEED_TRAINER_ADDED, 1, trainerID);
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* RemoveTrainer                                                           */
+/***************************************************************************/
+StatusType RemoveTrainer(void *DS, int trainerID) {
+	if (DS == NULL || trainerID <= 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	Iterator<Trainer> trainer = ds->trainers.search(Trainer(trainerID));
+	if (trainer == ds->trainers.end()) {
+		return FAILURE;
+	}
+	LevelIndex& trainerIndex = trainer.get()->getPokemons();
+	int numOfPokemons = trainerIndex.size();
+	// the trainer's keys, in level order for the level index and in ID order
+	// for the ID index, gathered before any index changes
+	LevelKey *keys = new (std::nothrow) LevelKey[numOfPokemons];
+	Pokemon *pokemons = new (std::nothrow) Pokemon[numOfPokemons];
+	if (keys == NULL || pokemons == NULL) {
+		delete[] keys;
+		delete[] pokemons;
+		return ALLOCATION_ERROR;
+	}
+	int i = 0;
+	for (Iterator<LevelKey> key = trainerIndex.begin();
+			key != trainerIndex.end(); ++key, i++) {
+		keys[i] = *key.get();
+		pokemons[i] = Pokemon(key.get()->pokemonID);
+	}
+	std::sort(pokemons, pokemons + numOfPokemons);
+
+	int oldTop = trainerIndex.top();
+	int oldGlobalTop = ds->pokemonsByLevel.top();
+	ds->pokemonsByLevel.removeSorted(keys, numOfPokemons);
+	ds->pokemons.removeSorted(pokemons, numOfPokemons);
+	ds->stats.removeGroup(trainer.get()->getStats(),
+			ds->pokemonsByLevel.maxLevel());
+	// releasing the trainer's node drops its level index with it
+	ds->trainers.tryRemove(trainer);
+	delete[] keys;
+	delete[] pokemons;
+	Emit(ds, FEED_TRAINER_REMOVED, 1, trainerID);
+	NotifyTop(ds, trainerID, oldTop, -1);
+	NotifyTop(ds, -1, oldGlobalTop, ds->pokemonsByLevel.top());
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* CatchPokemon                                                            */
+/***************************************************************************/
+StatusType CatchPokemon(void *DS, int pokemonID, int trainerID, int level) {
+	if (DS == NULL || pokemonID <= 0 || trainerID <= 0 || level <= 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	Trainer *trainer = FindTrainer(ds, trainerID);
+	if (trainer == NULL || FindPokemon(ds, pokemonID) != NULL) {
+		return FAILURE;
+	}
+	if (!ds->pokemons.reserve(1) || !ds->pokemonsByLevel.reserve(1)
+			|| !trainer->getPokemons().reserve(1)) {
+		return ALLOCATION_ERROR;
+	}
+	LevelKey key(level, pokemonID);
+	int oldTop = trainer->getPokemons().top();
+	int oldGlobalTop = ds->pokemonsByLevel.top();
+	ds->pokemons.tryInsert(Pokemon(pokemonID, trainerID, level));
+	ds->pokemonsByLevel.add(key);
+	trainer->getPokemons().add(key);
+	ds->stats.add(level);
+	trainer->getStats().add(level);
+	Emit(ds, FEED_CAUGHT, 3, pokemonID, trainerID, level);
+	NotifyTops(ds, trainer, oldTop, oldGlobalTop);
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* FreePokemon                                                             */
+/***************************************************************************/
+StatusType FreePokemon(void *DS, int pokemonID) {
+	if (DS == NULL || pokemonID <= 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	Iterator<Pokemon> pokemon = ds->pokemons.search(Pokemon(pokemonID));
+	if (pokemon == ds->pokemons.end()) {
+		return FAILURE;
+	}
+	LevelKey key(pokemon.get()->getLevel(), pokemonID);
+	Trainer *trainer = FindTrainer(ds, pokemon.get()->getTrainerID());
+	int oldTop = trainer->getPokemons().top();
+	int oldGlobalTop = ds->pokemonsByLevel.top();
+	trainer->getPokemons().remove(key);
+	ds->pokemonsByLevel.remove(key);
+	ds->pokemons.tryRemove(pokemon);
+	ds->stats.remove(key.level, ds->pokemonsByLevel.maxLevel());
+	trainer->getStats().remove(key.level, trainer->getPokemons().maxLevel());
+	Emit(ds, FEED_FREED, 1, pokemonID);
+	NotifyTops(ds, trainer, oldTop, oldGlobalTop);
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* LevelUp                                                                 */
+/***************************************************************************/
+StatusType LevelUp(void *DS, int pokemonID, int levelIncrease) {
+	if (DS == NULL || pokemonID <= 0 || levelIncrease <= 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	Pokemon *pokemon = FindPokemon(ds, pokemonID);
+	if (pokemon == NULL) {
+		return FAILURE;
+	}
+	LevelKey oldKey(pokemon->getLevel(), pokemonID);
+	LevelKey newKey(AddLevels(pokemon->getLevel(), levelIncrease), pokemonID);
+	Trainer *trainer = FindTrainer(ds, pokemon->getTrainerID());
+	LevelIndex& trainerIndex = trainer->getPokemons();
+	int oldTop = trainerIndex.top();
+	int oldGlobalTop = ds->pokemonsByLevel.top();
+	// every new key takes the node its old key gave back
+	trainerIndex.remove(oldKey);
+	trainerIndex.add(newKey);
+	ds->pokemonsByLevel.remove(oldKey);
+	ds->pokemonsByLevel.add(newKey);
+	pokemon->setLevel(newKey.level);
+	long long levelsDelta = (long long) newKey.level - oldKey.level;
+	ds->stats.changeLevels(levelsDelta, ds->pokemonsByLevel.maxLevel());
+	trainer->getStats().changeLevels(levelsDelta, trainerIndex.maxLevel());
+	Emit(ds, FEED_LEVEL_CHANGED, 2, pokemonID, newKey.level);
+	NotifyTops(ds, trainer, oldTop, oldGlobalTop);
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* EvolvePokemon                                                           */
+/***************************************************************************/
+StatusType EvolvePokemon(void *DS, int pokemonID, int evolvedID) {
+	if (DS == NULL || pokemonID <= 0 || evolvedID <= 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	Iterator<Pokemon> pokemon = ds->pokemons.search(Pokemon(pokemonID));
+	if (pokemon == ds->pokemons.end() || FindPokemon(ds, evolvedID) != NULL) {
+		return FAILURE;
+	}
+	Pokemon evolved(evolvedID, pokemon.get()->getTrainerID(),
+			pokemon.get()->getLevel());
+	LevelKey oldKey(evolved.getLevel(), pokemonID);
+	LevelKey newKey(evolved.getLevel(), evolvedID);
+	Trainer *trainer = FindTrainer(ds, evolved.getTrainerID());
+	LevelIndex& trainerIndex = trainer->getPokemons();
+	int oldTop = trainerIndex.top();
+	int oldGlobalTop = ds->pokemonsByLevel.top();
+	// every new entry takes the node its old entry gave back
+	ds->pokemons.tryRemove(pokemon);
+	ds->pokemons.tryInsert(evolved);
+	trainerIndex.remove(oldKey);
+	trainerIndex.add(newKey);
+	ds->pokemonsByLevel.remove(oldKey);
+	ds->pokemonsByLevel.add(newKey);
+	Emit(ds, FEED_EVOLVED, 2, pokemonID, evolvedID);
+	NotifyTops(ds, trainer, oldTop, oldGlobalTop);
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* TransferPokemon                                                         */
+/***************************************************************************/
+StatusType TransferPokemon(void *DS, int pokemonID, int newTrainerID) {
+	if (DS == NULL || pokemonID <= 0 || newTrainerID <= 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	Pokemon *pokemon = FindPokemon(ds, pokemonID);
+	Trainer *newTrainer = FindTrainer(ds, newTrainerID);
+	if (pokemon == NULL || newTrainer == NULL) {
+		return FAILURE;
+	}
+	if (!newTrainer->getPokemons().reserve(1)) {
+		return ALLOCATION_ERROR;
+	}
+	Trainer *oldTrainer = FindTrainer(ds, pokemon->getTrainerID());
+	LevelKey key(pokemon->getLevel(), pokemonID);
+	int oldTop = oldTrainer->getPokemons().top();
+	int oldNewTop = newTrainer->getPokemons().top();
+	oldTrainer->getPokemons().remove(key);
+	newTrainer->getPokemons().add(key);
+	pokemon->setTrainerID(newTrainerID);
+	oldTrainer->getStats().remove(key.level,
+			oldTrainer->getPokemons().maxLevel());
+	newTrainer->getStats().add(key.level);
+	Emit(ds, FEED_TRANSFERRED, 2, pokemonID, newTrainerID);
+	NotifyTop(ds, oldTrainer->getID(), oldTop, oldTrainer->getPokemons().top());
+	NotifyTop(ds, newTrainerID, oldNewTop, newTrainer->getPokemons().top());
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* TransferAll                                                             */
+/***************************************************************************/
+StatusType TransferAll(void *DS, int fromTrainerID, int toTrainerID) {
+	if (DS == NULL || fromTrainerID <= 0 || toTrainerID <= 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	Trainer *from = FindTrainer(ds, fromTrainerID);
+	Trainer *to = FindTrainer(ds, toTrainerID);
+	if (from == NULL || to == NULL) {
+		return FAILURE;
+	}
+	if (from == to) {
+		Emit(ds, FEED_TRANSFERRED_ALL, 2, fromTrainerID, toTrainerID);
+		return SUCCESS;
+	}
+	// re-parent the moved pokemons first: the merge is the only step that
+	// can fail, and then it has to leave the DS unchanged
+	for (Iterator<LevelKey> key = from->getPokemons().begin();
+			key != from->getPokemons().end(); ++key) {
+		FindPokemon(ds, key.get()->pokemonID)->setTrainerID(toTrainerID);
+	}
+	int oldFromTop = from->getPokemons().top();
+	int oldToTop = to->getPokemons().top();
+	if (!to->getPokemons().merge(from->getPokemons())) {
+		for (Iterator<LevelKey> key = from->getPokemons().begin();
+				key != from->getPokemons().end(); ++key) {
+			FindPokemon(ds, key.get()->pokemonID)->setTrainerID(fromTrainerID);
+		}
+		return ALLOCATION_ERROR;
+	}
+	to->getStats().addGroup(from->getStats(), to->getPokemons().maxLevel());
+	from->getStats() = TrainerStats();
+	Emit(ds, FEED_TRANSFERRED_ALL, 2, fromTrainerID, toTrainerID);
+	NotifyTop(ds, fromTrainerID, oldFromTop, -1);
+	NotifyTop(ds, toTrainerID, oldToTop, to->getPokemons().top());
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* GetTopPokemon                                                           */
+/***************************************************************************/
+StatusType GetTopPokemon(void *DS, int trainerID, int *pokemonID) {
+	if (DS == NULL || pokemonID == NULL || trainerID == 0) {
+		return INVALID_INPUT;
+	}
+	LevelIndex *index = QueriedIndex((DataStructure*) DS, trainerID);
+	if (index == NULL) {
+		return FAILURE;
+	}
+	*pokemonID = index->top();
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* GetAllPokemonsByLevel                                                   */
+/***************************************************************************/
+StatusType GetAllPokemonsByLevel(void *DS, int trainerID, int **pokemons,
+		int *numOfPokemon) {
+	if (DS == NULL || pokemons == NULL || numOfPokemon == NULL
+			|| trainerID == 0) {
+		return INVALID_INPUT;
+	}
+	LevelIndex *index = QueriedIndex((DataStructure*) DS, trainerID);
+	if (index == NULL) {
+		return FAILURE;
+	}
+	int size = index->size();
+	int *ids = NULL;
+	if (size > 0) {
+		ids = (int*) malloc(sizeof(int) * size);
+		if (ids == NULL) {
+			return ALLOCATION_ERROR;
+		}
+	}
+	int i = 0;
+	for (Iterator<LevelKey> key = index->begin(); key != index->end(); ++key) {
+		ids[i++] = key.get()->pokemonID;
+	}
+	*pokemons = ids;
+	*numOfPokemon = size;
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* GetTrainerStats                                                         */
+/***************************************************************************/
+StatusType GetTrainerStats(void *DS, int trainerID, int *numOfPokemon,
+		long long *sumOfLevels, int *maxLevel) {
+	if (DS == NULL || numOfPokemon == NULL || sumOfLevels == NULL
+			|| maxLevel == NULL || trainerID == 0) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	const TrainerStats *stats = &ds->stats;
+	if (trainerID > 0) {
+		Trainer *trainer = FindTrainer(ds, trainerID);
+		if (trainer == NULL) {
+			return FAILURE;
+		}
+		stats = &trainer->getStats();
+	}
+	*numOfPokemon = stats->numOfPokemons;
+	*sumOfLevels = stats->sumOfLevels;
+	*maxLevel = stats->maxLevel;
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* UpdateLevels                                                            */
+/***************************************************************************/
+StatusType UpdateLevels(void *DS, int stoneCode, int stoneFactor) {
+	if (DS == NULL || stoneCode < 1 || stoneFactor < 1) {
+		return INVALID_INPUT;
+	}
+	DataStructure *ds = (DataStructure*) DS;
+	int numOfPokemons = ds->pokemons.size();
+	if (numOfPokemons == 0) {
+		Emit(ds, FEED_LEVELS_UPDATED, 2, stoneCode, stoneFactor);
+		return SUCCESS;
+	}
+	// the only allocations, made before any index changes; every level index
+	// is then rebuilt in place. with a watch, the top pokemons of the
+	// trainers are kept too, so it is notified once the update is complete
+	LevelKey *scratch = new (std::nothrow) LevelKey[2 * numOfPokemons];
+	int *oldTops = (ds->watch == NULL) ?
+			NULL : new (std::nothrow) int[ds->trainers.size()];
+	if (scratch == NULL || (ds->watch != NULL && oldTops == NULL)) {
+		delete[] scratch;
+		delete[] oldTops;
+		return ALLOCATION_ERROR;
+	}
+	for (Iterator<Pokemon> iter = ds->pokemons.begin();
+			iter != ds->pokemons.end(); ++iter) {
+		Pokemon *pokemon = iter.get();
+		if (pokemon->getID() % stoneCode == 0) {
+			pokemon->setLevel(MultiplyLevel(pokemon->getLevel(), stoneFactor));
+		}
+	}
+	int oldGlobalTop = ds->pokemonsByLevel.top();
+	long long levelsDelta = ds->pokemonsByLevel.updateLevels(stoneCode,
+			stoneFactor, scratch);
+	ds->stats.changeLevels(levelsDelta, ds->pokemonsByLevel.maxLevel());
+	int t = 0;
+	for (Iterator<Trainer> trainer = ds->trainers.begin();
+			trainer != ds->trainers.end(); ++trainer, t++) {
+		LevelIndex& trainerIndex = trainer.get()->getPokemons();
+		if (oldTops != NULL) {
+			oldTops[t] = trainerIndex.top();
+		}
+		levelsDelta = trainerIndex.updateLevels(stoneCode, stoneFactor, scratch);
+		trainer.get()->getStats().changeLevels(levelsDelta,
+				trainerIndex.maxLevel());
+	}
+	delete[] scratch;
+	Emit(ds, FEED_LEVELS_UPDATED, 2, stoneCode, stoneFactor);
+	if (oldTops != NULL) {
+		t = 0;
+		for (Iterator<Trainer> trainer = ds->trainers.begin();
+				trainer != ds->trainers.end(); ++trainer, t++) {
+			NotifyTop(ds, trainer.get()->getID(), oldTops[t],
+					trainer.get()->getPokemons().top());
+		}
+		delete[] oldTops;
+	}
+	NotifyTop(ds, -1, oldGlobalTop, ds->pokemonsByLevel.top());
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* SetChangeFeed                                                           */
+/***************************************************************************/
+StatusType SetChangeFeed(void *DS, ChangeFeed *feed) {
+	if (DS == NULL) {
+		return INVALID_INPUT;
+	}
+	((DataStructure*) DS)->feed = feed;
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* SetTopWatch                                                             */
+/***************************************************************************/
+StatusType SetTopWatch(void *DS, TopWatch *watch) {
+	if (DS == NULL) {
+		return INVALID_INPUT;
+	}
+	((DataStructure*) DS)->watch = watch;
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* SaveSnapshot                                                            */
+/***************************************************************************/
+
+/* Fills data with the sections of the DS (see snapshot.h), allocated with
+ * malloc and released by SnapshotFree. */
+static StatusType FillSnapshotData(DataStructure *ds, SnapshotData *data) {
+	data->numOfTrainers = ds->trainers.size();
+	data->numOfPokemons = ds->pokemons.size();
+	// malloc(0) may return NULL, so always ask for at least one record
+	data->trainers = (TrainerRecord*) malloc(
+			sizeof(TrainerRecord) * (data->numOfTrainers + 1));
+	data->pokemonsByID = (PokemonRecord*) malloc(
+			sizeof(PokemonRecord) * (data->numOfPokemons + 1));
+	data->pokemonsByLevel = (PokemonRecord*) malloc(
+			sizeof(PokemonRecord) * (data->numOfPokemons + 1));
+	if (data->trainers == NULL || data->pokemonsByID == NULL
+			|| data->pokemonsByLevel == NULL) {
+		SnapshotFree(data);
+		return ALLOCATION_ERROR;
+	}
+
+	int i = 0;
+	for (Iterator<Trainer> trainer = ds->trainers.begin();
+			trainer != ds->trainers.end(); ++trainer) {
+		data->trainers[i++].trainerID = trainer.get()->getID();
+	}
+	i = 0;
+	for (Iterator<Pokemon> iter = ds->pokemons.begin();
+			iter != ds->pokemons.end(); ++iter) {
+		PokemonRecord& record = data->pokemonsByID[i++];
+		record.pokemonID = iter.get()->getID();
+		record.trainerID = iter.get()->getTrainerID();
+		record.level = iter.get()->getLevel();
+	}
+	i = 0;
+	for (Iterator<LevelKey> key = ds->pokemonsByLevel.begin();
+			key != ds->pokemonsByLevel.end(); ++key) {
+		PokemonRecord& record = data->pokemonsByLevel[i++];
+		record.pokemonID = key.get()->pokemonID;
+		record.trainerID = FindPokemon(ds, record.pokemonID)->getTrainerID();
+		record.level = key.get()->level;
+	}
+	return SUCCESS;
+}
+
+StatusType SaveSnapshot(void *DS, const char *path) {
+	if (DS == NULL || path == NULL) {
+		return INVALID_INPUT;
+	}
+	SnapshotData data;
+	StatusType result = FillSnapshotData((DataStructure*) DS, &data);
+	if (result != SUCCESS) {
+		return result;
+	}
+	result = SnapshotWrite(path, &data);
+	SnapshotFree(&data);
+	return result;
+}
+
+/***************************************************************************/
+/* FrozenSave                                                              */
+/***************************************************************************/
+StatusType FrozenSave(void *DS, const char *path) {
+	if (DS == NULL || path == NULL) {
+		return INVALID_INPUT;
+	}
+	SnapshotData data;
+	StatusType result = FillSnapshotData((DataStructure*) DS, &data);
+	if (result != SUCCESS) {
+		return result;
+	}
+	result = FrozenWrite(path, &data);
+	SnapshotFree(&data);
+	return result;
+}
+
+/***************************************************************************/
+/* LoadSnapshot                                                            */
+/***************************************************************************/
+
+/* The position of trainerID in the (sorted) trainers section. The trainer
+ * must be there. */
+static int TrainerPosition(const SnapshotData *data, int trainerID) {
+	int low = 0;
+	int high = data->numOfTrainers - 1;
+	while (low < high) {
+		int middle = low + (high - low) / 2;
+		if (data->trainers[middle].trainerID < trainerID) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+/* Builds a new DS from valid sections (see SnapshotRead), every index with
+ * buildFromSorted. NULL in case of an allocation error. */
+static DataStructure* BuildFromSnapshot(const SnapshotData *data) {
+	int numOfTrainers = data->numOfTrainers;
+	int numOfPokemons = data->numOfPokemons;
+	DataStructure *ds = new (std::nothrow) DataStructure();
+	Trainer *trainers = new (std::nothrow) Trainer[numOfTrainers];
+	Pokemon *pokemons = new (std::nothrow) Pokemon[numOfPokemons];
+	LevelKey *keys = new (std::nothrow) LevelKey[numOfPokemons];
+	int *positions = new (std::nothrow) int[numOfPokemons];
+	int *offsets = new (std::nothrow) int[numOfTrainers + 1];
+	bool ok = ds != NULL && trainers != NULL && pokemons != NULL
+			&& keys != NULL && positions != NULL && offsets != NULL;
+
+	if (ok) {
+		for (int i = 0; i < numOfTrainers; i++) {
+			trainers[i] = Trainer(data->trainers[i].trainerID);
+		}
+		for (int i = 0; i < numOfPokemons; i++) {
+			const PokemonRecord& record = data->pokemonsByID[i];
+			pokemons[i] = Pokemon(record.pokemonID, record.trainerID,
+					record.level);
+			const PokemonRecord& byLevel = data->pokemonsByLevel[i];
+			keys[i] = LevelKey(byLevel.level, byLevel.pokemonID);
+			ds->stats.add(byLevel.level);
+		}
+		ok = ds->trainers.buildFromSorted(trainers, numOfTrainers)
+				&& ds->pokemons.buildFromSorted(pokemons, numOfPokemons)
+				&& ds->pokemonsByLevel.build(keys, numOfPokemons);
+	}
+	if (ok) {
+		// group the level section by trainer, keeping its order, so every
+		// trainer's keys are a sorted run of keys
+		for (int i = 0; i <= numOfTrainers; i++) {
+			offsets[i] = 0;
+		}
+		for (int i = 0; i < numOfPokemons; i++) {
+			positions[i] = TrainerPosition(data,
+					data->pokemonsByLevel[i].trainerID);
+			offsets[positions[i] + 1]++;
+		}
+		for (int i = 0; i < numOfTrainers; i++) {
+			offsets[i + 1] += offsets[i];
+		}
+		for (int i = 0; i < numOfPokemons; i++) {
+			const PokemonRecord& record = data->pokemonsByLevel[i];
+			keys[offsets[positions[i]]++] = LevelKey(record.level,
+					record.pokemonID);
+		}
+		// offsets[t] is now where trainer t's run ends
+		int start = 0;
+		int t = 0;
+		for (Iterator<Trainer> trainer = ds->trainers.begin();
+				ok && trainer != ds->trainers.end(); ++trainer, t++) {
+			ok = trainer.get()->getPokemons().build(keys + start,
+					offsets[t] - start);
+			for (int i = start; i < offsets[t]; i++) {
+				trainer.get()->getStats().add(keys[i].level);
+			}
+			start = offsets[t];
+		}
+	}
+
+	delete[] trainers;
+	delete[] pokemons;
+	delete[] keys;
+	delete[] positions;
+	delete[] offsets;
+	if (!ok) {
+		delete ds;
+		return NULL;
+	}
+	return ds;
+}
+
+void* LoadSnapshot(const char *path) {
+	if (path == NULL) {
+		return NULL;
+	}
+	SnapshotData data;
+	if (SnapshotRead(path, &data) != SUCCESS) {
+		return NULL;
+	}
+	DataStructure *ds = BuildFromSnapshot(&data);
+	SnapshotFree(&data);
+	return ds;
+}
+
+/***************************************************************************/
+/* Thaw                                                                    */
+/***************************************************************************/
+void* Thaw(const struct FrozenSnapshot *snapshot) {
+	if (snapshot == NULL) {
+		return NULL;
+	}
+	SnapshotData data;
+	if (FrozenToSnapshotData(snapshot, &data) != SUCCESS) {
+		return NULL;
+	}
+	// FrozenOpen checks only the layout of the file, not its contents
+	DataStructure *ds = (SnapshotValidate(&data) == SUCCESS) ?
+			BuildFromSnapshot(&data) : NULL;
+	SnapshotFree(&data);
+	return ds;
+}
+
+/***************************************************************************/
+/* Quit                                                                    */
+/***************************************************************************/
+void Quit(void** DS) {
+	if (DS == NULL) {
+		return;
+	}
+	delete (DataStructure*) *DS;
+	*DS = NULL;
+}
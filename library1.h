@@ -27,6 +27,15 @@ typedef enum {
     INVALID_INPUT = -3
 } StatusType;
 
+/* An open, read-only snapshot of the DS (see frozenSnapshot.h). */
+typedef struct FrozenSnapshot FrozenSnapshot;
+
+/* A stream of the changes made to the DS (see changeFeed.h). */
+typedef struct ChangeFeed ChangeFeed;
+
+/* Subscriptions to the top pokemons of the DS (see topWatch.h). */
+typedef struct TopWatch TopWatch;
+
 /* Required Interface for the Data Structure
  * -----------------------------------------*/
 
@@ -37,6 +46,23 @@ typedef enum {
  */
 void* Init();
 
+/* Description:   Reserves room for trainers and pokemons ahead of time.
+ *                Every index of the DS keeps a reserve of tree nodes; a mutation
+ *                takes all the nodes it needs from the reserves before changing
+ *                any index, so it never fails halfway. Once enough capacity is
+ *                reserved, AddTrainer doesn't allocate memory, and CatchPokemon
+ *                allocates only when the trainer's own level index, which
+ *                grows in blocks of nodes, runs out of room.
+ * Input:         DS - A pointer to the data structure.
+ *                numOfTrainers - The number of trainers to make room for.
+ *                numOfPokemons - The number of pokemons to make room for.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error, the DS is left unchanged.
+ *                INVALID_INPUT - If DS==NULL, or if numOfTrainers < 0, or if numOfPokemons < 0.
+ *                SUCCESS - Otherwise.
+ */
+StatusType ReserveCapacity(void *DS, int numOfTrainers, int numOfPokemons);
+
 /* Description:   Adds a new trainer.
  * Input:         DS - A pointer to the data structure.
  *                trainerID - The ID of the trainer to add.
@@ -48,6 +74,21 @@ void* Init();
  */
 StatusType AddTrainer(void *DS, int trainerID);
 
+/* Description:   Removes a trainer together with all his pokemons.
+ *                The trainer's level index is dropped in O(m) and his m pokemons
+ *                are removed from the global indexes in bulk: one at a time when
+ *                m is small, otherwise in a single pass that rebuilds each index.
+ *                Sorting the m IDs for the ID index takes O(m log m).
+ * Input:         DS - A pointer to the data structure.
+ *                trainerID - The ID of the trainer to remove.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If DS==NULL or if trainerID <= 0.
+ *                FAILURE - If trainerID isn't in the DS.
+ *                SUCCESS - Otherwise.
+ */
+StatusType RemoveTrainer(void *DS, int trainerID);
+
 /* Description:   Adds a new pokemon to the system.
  * Input:         DS - A pointer to the data structure.
  *                pokemonID - ID of the pokemon to add.
@@ -120,6 +161,20 @@ StatusType GetTopPokemon(void *DS, int trainerID, int *pokemonID);
  */
 StatusType GetAllPokemonsByLevel(void *DS, int trainerID, int **pokemons, int *numOfPokemon);
 
+/* Description:   Returns statistics of the pokemons of trainerID, in O(1).
+ *                The statistics are maintained by every mutation, including UpdateLevels.
+ * 			          If trainerID < 0, returns the statistics of all the pokemons in the DS.
+ * Input:         DS - A pointer to the data structure.
+ *                trainerID - The trainer that we'd like to get the data for.
+ * Output:        numOfPokemon - Updated to the number of pokemons.
+ *                sumOfLevels - Updated to the sum of the pokemons' levels.
+ *                maxLevel - Updated to the highest level of a pokemon, or 0 if there are no pokemons.
+ * Return Values: INVALID_INPUT - If any of the arguments is NULL or if trainerID == 0.
+ *                FAILURE - If trainerID isn't in the DS.
+ *                SUCCESS - Otherwise.
+ */
+StatusType GetTrainerStats(void *DS, int trainerID, int *numOfPokemon, long long *sumOfLevels, int *maxLevel);
+
 /* Description:   Updates the level of the pokemons where pokemonID % stoneCode == 0.
  * 			          For each matching pokemon, multiplies its level by stoneFactor.
  * Input:         DS - A pointer to the data structure.
@@ -132,6 +187,108 @@ StatusType GetAllPokemonsByLevel(void *DS, int trainerID, int **pokemons, int *n
  */
 StatusType UpdateLevels(void *DS, int stoneCode, int stoneFactor);
 
+/* Description:   Moves a pokemon to another trainer, keeping its ID and level.
+ *                Only the level indexes of the two trainers change, in O(log n).
+ * Input:         DS - A pointer to the data structure.
+ *                pokemonID - The ID of the pokemon to move.
+ *                newTrainerID - The ID of the pokemon's new trainer.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If DS==NULL, or if pokemonID <= 0, or if newTrainerID <= 0.
+ *                FAILURE - If pokemonID isn't in the DS, or newTrainerID isn't in the DS.
+ *                SUCCESS - Otherwise.
+ */
+StatusType TransferPokemon(void *DS, int pokemonID, int newTrainerID);
+
+/* Description:   Moves all the pokemons of one trainer to another trainer.
+ *                The two trainers' level indexes are merged in O(m1 + m2), instead
+ *                of moving the pokemons one at a time; the m1 moved pokemons are
+ *                then re-parented in the ID index in O(m1 log n).
+ * Input:         DS - A pointer to the data structure.
+ *                fromTrainerID - The trainer whose pokemons are moved. It stays
+ *                in the DS with no pokemons.
+ *                toTrainerID - The trainer that receives the pokemons.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error, the DS is left unchanged.
+ *                INVALID_INPUT - If DS==NULL, or if fromTrainerID <= 0, or if toTrainerID <= 0.
+ *                FAILURE - If fromTrainerID or toTrainerID aren't in the DS.
+ *                SUCCESS - Otherwise.
+ */
+StatusType TransferAll(void *DS, int fromTrainerID, int toTrainerID);
+
+/* Description:   Attaches a change feed to the DS (see changeFeed.h). From now
+ *                on every successful call to AddTrainer, RemoveTrainer,
+ *                CatchPokemon, FreePokemon, LevelUp, EvolvePokemon, UpdateLevels,
+ *                TransferPokemon and TransferAll emits its event to the feed.
+ * Input:         DS - A pointer to the data structure.
+ *                feed - The feed to emit to, or NULL to detach the current one.
+ *                The DS doesn't own the feed.
+ * Output:        None.
+ * Return Values: INVALID_INPUT - If DS==NULL.
+ *                SUCCESS - Otherwise.
+ */
+StatusType SetChangeFeed(void *DS, ChangeFeed *feed);
+
+/* Description:   Attaches a top pokemon watch to the DS (see topWatch.h). From
+ *                now on every successful mutation that changes the top pokemon
+ *                of a trainer, or of the whole DS, notifies the watch.
+ * Input:         DS - A pointer to the data structure.
+ *                watch - The watch to notify, or NULL to detach the current one.
+ *                The DS doesn't own the watch.
+ * Output:        None.
+ * Return Values: INVALID_INPUT - If DS==NULL.
+ *                SUCCESS - Otherwise.
+ */
+StatusType SetTopWatch(void *DS, TopWatch *watch);
+
+/* Description:   Saves the whole DS to a binary snapshot file (see snapshot.h).
+ * Input:         DS - A pointer to the data structure.
+ *                path - The file to write. An existing file is replaced only
+ *                once the new snapshot is completely written.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If DS==NULL or if path==NULL.
+ *                FAILURE - If writing the file failed.
+ *                SUCCESS - Otherwise.
+ */
+StatusType SaveSnapshot(void *DS, const char *path);
+
+/* Description:   Saves the whole DS to a frozen snapshot file (see
+ *                frozenSnapshot.h), for read-only replicas to map with
+ *                FrozenOpen.
+ * Input:         DS - A pointer to the data structure.
+ *                path - The file to write. An existing file is replaced only
+ *                once the new snapshot is completely written.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If DS==NULL or if path==NULL.
+ *                FAILURE - If writing the file failed.
+ *                SUCCESS - Otherwise.
+ */
+StatusType FrozenSave(void *DS, const char *path);
+
+/* Description:   Creates a new instance of the data structure from a snapshot
+ *                file written by SaveSnapshot. The records are checked in
+ *                O(n log n) (see SnapshotRead), then every index is rebuilt in
+ *                O(n) from them.
+ * Input:         path - The snapshot file to read.
+ * Output:        None.
+ * Return Values: A pointer to the new instance of the data structure - as a void* pointer,
+ *                or NULL if path==NULL, the file isn't a valid snapshot, or in case of an allocation error.
+ */
+void* LoadSnapshot(const char *path);
+
+
+/* Description:   Creates a new, mutable instance of the data structure from a
+ *                frozen snapshot (see frozenSnapshot.h). A frozen snapshot is
+ *                only queried in place; it has to be thawed before any mutation.
+ * Input:         snapshot - An open frozen snapshot. It stays open and unchanged.
+ * Output:        None.
+ * Return Values: A pointer to the new instance of the data structure - as a void* pointer,
+ *                or NULL if snapshot==NULL, its sections aren't valid (see
+ *                SnapshotValidate), or in case of an allocation error.
+ */
+void* Thaw(const struct FrozenSnapshot *snapshot);
 
 /* Description:   Quits and deletes the database.
  *                DS should be set to NULL.
@@ -12,15 +12,47 @@
 /*                                                                         */
 /* Holds the "int main()" function and the parser of the shell's           */
 /* command line.                                                           */
+/*                                                                         */
+/* Usage: main1 [-i] [-p] [-b] [-B] [-V] [-q] [command file]               */
+/*        main1 -s socket [-B] [-V] [-q]                                   */
+/* Reads the commands from the file if one is given (mapped, not copied),  */
+/* and from stdin otherwise. -i flushes the output after every command.    */
+/* -p reads, executes and prints the commands in three pipelined threads.  */
+/* -b reads binary commands (binaryProtocol.h) instead of text.            */
+/* -B prints the latencies of the commands instead of their output.        */
+/* -V checks every result against a reference model (refModel.h).          */
+/* -q prints a summary of the commands' results instead of their output.   */
+/* -s serves the commands of any number of clients on a Unix socket, until */
+/* SIGINT or SIGTERM; -B, -V and -q then cover all of them. The server     */
+/* runs Init and Quit itself, so no client can replace or free the DS.     */
 /***************************************************************************/
 
 #include <assert.h>
+#include <errno.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include "library1.h"
-#include <iostream>
-using namespace std;
+#include "tokenizer.h"
+#include "formatter.h"
+#include "spscRing.h"
+#include "binaryProtocol.h"
+#include "latencyHistogram.h"
+#include "refModel.h"
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -28,6 +60,7 @@ extern "C" {
 
 /* The command's strings */
 typedef enum {
+	END_CMD = -3,
 	NONE_CMD = -2,
 	COMMENT_CMD = -1,
 	INIT_CMD = 0,
@@ -46,6 +79,8 @@ static const int numActions = 10;
 static const char *commandStr[] = { "Init", "AddTrainer", "CatchPokemon",
 		"FreePokemon", "LevelUp", "EvolvePokemon",
 		"GetTopPokemon", "GetAllPokemonsByLevel", "UpdateLevels", "Quit" };
+/* The number of arguments each command reads */
+static const int commandArgs[] = { 0, 1, 3, 1, 2, 2, 1, 1, 2, 0 };
 
 static const char* ReturnValToStr(int val) {
 	switch (val) {
@@ -66,50 +101,1254 @@ static const char* ReturnValToStr(int val) {
 #define MAX_STRING_INPUT_SIZE (255)
 #define MAX_BUFFER_SIZE       (255)
 
-#define StrCmp(Src1,Src2) ( strncmp((Src1),(Src2),strlen(Src1)) == 0 )
-
 typedef enum {
 	error_free, error
 } errorType;
-static errorType parser(const char* const command);
 
-#define ValidateRead(read_parameters,required_parameters,ErrorString) \
-if ( (read_parameters)!=(required_parameters) ) { printf(ErrorString); return error; }
+/* A command line on its way through the shell: filled in by ParseCommand,
+ * then by ExecuteCommand with the outcome, which PrintCommand prints. */
+typedef struct {
+	commandType type;
+	int numOfArgs; /* The number of arguments read */
+	int args[3];
+	const char* text; /* COMMENT_CMD: the line to echo, textLength long */
+	size_t textLength;
+	bool ownsText; /* text was copied with malloc */
+	StatusType res; /* Init: FAILURE if already called, ALLOCATION_ERROR if failed */
+	int pokemonID; /* GetTopPokemon */
+	int* pokemons; /* GetAllPokemonsByLevel */
+	int numOfPokemons;
+} Command;
+
+static void ParseCommand(const char* const line, Command* command);
+static errorType ExecuteCommand(Command* command);
+static void PrintCommand(Command* command);
+static void DiscardCommand(Command* command);
+static errorType parser(const char* const command);
 
 static bool isInit = false;
 
 /***************************************************************************/
-/* main                                                                    */
+/* Output                                                                  */
 /***************************************************************************/
 
-int main(int argc, const char**argv) {
+/* All the shell's output goes through one buffer, written to stdout when it
+ * fills up, when the shell exits, or after every command in interactive mode
+ * (-i, or when stdin is a terminal). The server (-s) points output at the
+ * buffer of the connection whose commands run; those buffers grow instead,
+ * and the server writes them to their sockets. */
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+
+typedef struct {
+	char* data;
+	size_t used;
+	size_t capacity;
+	bool growable; /* A connection's buffer: grows instead of being flushed */
+	bool failed;   /* It couldn't grow, the output since is lost */
+} OutputBuffer;
+
+static char stdoutData[OUTPUT_BUFFER_SIZE];
+static OutputBuffer stdoutBuffer = { stdoutData, 0, OUTPUT_BUFFER_SIZE, false,
+		false };
+static OutputBuffer* output = &stdoutBuffer;
+static char lostOutput[OUTPUT_BUFFER_SIZE]; /* Room given once output failed */
+static bool interactive = false;
+
+static void WriteAll(const char* data, size_t length) {
+	while (length > 0) {
+		ssize_t written = write(STDOUT_FILENO, data, length);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return;
+		data += written;
+		length -= written;
+	};
+}
+
+static void OutFlush() {
+	WriteAll(stdoutBuffer.data, stdoutBuffer.used);
+	stdoutBuffer.used = 0;
+}
+
+/* Makes room for length more characters in the output, flushing stdout's
+ * buffer or growing a connection's. Returns false if there is none: the
+ * text is longer than stdout's buffer, or a connection's couldn't grow. */
+static bool OutRoom(size_t length) {
+	if (output->used + length <= output->capacity)
+		return true;
+	if (!output->growable) {
+		OutFlush();
+		return length <= output->capacity;
+	};
+	if (output->failed)
+		return false;
+	size_t capacity = 2 * output->capacity + OUTPUT_BUFFER_SIZE;
+	if (capacity < output->used + length)
+		capacity = output->used + length;
+	char* data = (char*) realloc(output->data, capacity);
+	if (data == NULL) {
+		output->failed = true;
+		return false;
+	};
+	output->data = data;
+	output->capacity = capacity;
+	return true;
+}
+
+static void OutWrite(const char* text, size_t length) {
+	if (!OutRoom(length)) {
+		if (!output->growable)
+			WriteAll(text, length);
+		return;
+	};
+	memcpy(output->data + output->used, text, length);
+	output->used += length;
+}
+
+/* Returns room for length more characters at the end of the output. length
+ * must not exceed OUTPUT_BUFFER_SIZE. The caller fills the room and passes
+ * what it used to OutCommit. */
+static char* OutReserve(size_t length) {
+	return OutRoom(length) ? output->data + output->used : lostOutput;
+}
+
+static void OutCommit(size_t length) {
+	if (!output->failed)
+		output->used += length;
+}
+
+static void OutPrintf(const char* format, ...) {
+	char line[MAX_BUFFER_SIZE + 1];
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	if (length < 0)
+		return;
+	if ((size_t) length < sizeof(line)) {
+		OutWrite(line, length);
+		return;
+	};
+	// longer than a line (an echoed comment), format it again in place
+	char* longLine = (char*) malloc(length + 1);
+	if (longLine == NULL)
+		return;
+	va_start(args, format);
+	vsnprintf(longLine, length + 1, format, args);
+	va_end(args);
+	OutWrite(longLine, length);
+	free(longLine);
+}
+
+/***************************************************************************/
+/* Benchmark                                                               */
+/***************************************************************************/
+
+/* The benchmark (-B) times the execution of every command and, instead of
+ * the commands' output, prints the latencies of each command type when the
+ * input ends. Times are read from the TSC where there is one, and converted
+ * to ns by the TSC rate measured against steady_clock over the whole run. */
+static bool benchmark = false;
+static LatencyHistogram latencies[numActions];
+static uint64_t executingTicks = 0;
+
+static inline uint64_t ReadClock() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static errorType ExecuteTimed(Command* command) {
+	if (!benchmark)
+		return ExecuteCommand(command);
+	uint64_t start = ReadClock();
+	errorType rtn_val = ExecuteCommand(command);
+	uint64_t ticks = ReadClock() - start;
+	if (command->type >= 0) {
+		HistogramRecord(&latencies[command->type], ticks);
+		executingTicks += ticks;
+	};
+	return rtn_val;
+}
+
+static void PrintLatencies(uint64_t runTicks, double runSeconds) {
+	double ticksPerNs = (runSeconds > 0) ? runTicks / (runSeconds * 1e9) : 1;
+	if (ticksPerNs <= 0)
+		ticksPerNs = 1;
+	uint64_t numOfCommands = 0;
+	OutPrintf("%-24s %12s %10s %10s %10s %10s\n", "Command", "Count",
+			"p50(ns)", "p99(ns)", "p999(ns)", "max(ns)");
+	for (int type = 0; type < numActions; type++) {
+		const LatencyHistogram* histogram = &latencies[type];
+		if (histogram->totalCount == 0)
+			continue;
+		numOfCommands += histogram->totalCount;
+		OutPrintf("%-24s %12llu %10.0f %10.0f %10.0f %10.0f\n",
+				commandStr[type], (unsigned long long) histogram->totalCount,
+				HistogramPercentile(histogram, 50) / ticksPerNs,
+				HistogramPercentile(histogram, 99) / ticksPerNs,
+				HistogramPercentile(histogram, 99.9) / ticksPerNs,
+				histogram->maxValue / ticksPerNs);
+	};
+	double executingSeconds = executingTicks / ticksPerNs / 1e9;
+	OutPrintf("%llu commands in %.3f s: %.0f commands/s "
+			"(%.3f s executing: %.0f commands/s)\n",
+			(unsigned long long) numOfCommands, runSeconds,
+			runSeconds > 0 ? numOfCommands / runSeconds : 0, executingSeconds,
+			executingSeconds > 0 ? numOfCommands / executingSeconds : 0);
+}
+
+/***************************************************************************/
+/* Quiet                                                                   */
+/***************************************************************************/
+
+/* The quiet mode (-q) prints nothing per command, only a summary of the
+ * results of each command type when the input ends. */
+#define NUM_OF_STATUSES (4)
+
+static bool quiet = false;
+/* statusCounts[type][-res] for the StatusType res, malformed[type] for the
+ * commands whose arguments couldn't be read */
+static long long statusCounts[numActions][NUM_OF_STATUSES];
+static long long malformed[numActions];
+
+static void CountCommand(const Command* command) {
+	if (command->type < 0)
+		return;
+	if (command->numOfArgs < commandArgs[command->type])
+		malformed[command->type]++;
+	else if (command->res <= 0 && -command->res < NUM_OF_STATUSES)
+		statusCounts[command->type][-command->res]++;
+}
+
+static void PrintStatusCounts() {
+	OutPrintf("%-24s %12s %12s %14s %17s %12s\n", "Command",
+			ReturnValToStr(SUCCESS), ReturnValToStr(FAILURE),
+			ReturnValToStr(INVALID_INPUT), ReturnValToStr(ALLOCATION_ERROR),
+			"malformed");
+	long long totals[NUM_OF_STATUSES] = { 0 };
+	long long totalMalformed = 0;
+	for (int type = 0; type < numActions; type++) {
+		const long long* counts = statusCounts[type];
+		if (counts[-SUCCESS] + counts[-FAILURE] + counts[-INVALID_INPUT]
+				+ counts[-ALLOCATION_ERROR] + malformed[type] == 0)
+			continue;
+		OutPrintf("%-24s %12lld %12lld %14lld %17lld %12lld\n",
+				commandStr[type], counts[-SUCCESS], counts[-FAILURE],
+				counts[-INVALID_INPUT], counts[-ALLOCATION_ERROR],
+				malformed[type]);
+		for (int status = 0; status < NUM_OF_STATUSES; status++)
+			totals[status] += counts[status];
+		totalMalformed += malformed[type];
+	};
+	OutPrintf("%-24s %12lld %12lld %14lld %17lld %12lld\n", "Total",
+			totals[-SUCCESS], totals[-FAILURE], totals[-INVALID_INPUT],
+			totals[-ALLOCATION_ERROR], totalMalformed);
+}
+
+static void OutputCommand(Command* command) {
+	if (quiet)
+		CountCommand(command);
+	if (benchmark || quiet)
+		DiscardCommand(command);
+	else
+		PrintCommand(command);
+}
+
+/***************************************************************************/
+/* Verification                                                            */
+/***************************************************************************/
+
+/* The verification (-V) runs every command on a RefModel (refModel.h) too,
+ * and compares the results of the DS with the model's. The first difference
+ * is reported on stderr and stops the shell, since the DS and the model
+ * differ from there on. In the cases library1.h leaves open, the model's
+ * results are its own assumptions (see RefModel). */
+static bool verify = false;
+static bool verifyFailed = false;
+static RefModel model;
+static bool modelInit = false;
+static long long verifiedCommands = 0;
+
+static void ReportMismatch(const Command* command, const char* what,
+		long long actual, long long expected) {
+	fprintf(stderr, "verify: command %lld (%s", verifiedCommands,
+			commandStr[command->type]);
+	for (int i = 0; i < command->numOfArgs; i++)
+		fprintf(stderr, " %d", command->args[i]);
+	fprintf(stderr, "): %s %lld, the model %lld\n", what, actual, expected);
+	verifyFailed = true;
+}
+
+static errorType VerifyCommand(const Command* command) {
+	if (!verify || command->type < 0
+			|| command->numOfArgs < commandArgs[command->type])
+		return error_free;
+	verifiedCommands++;
+	const int* args = command->args;
+	StatusType expected = INVALID_INPUT; /* Before Init, DS==NULL */
+	int expectedPokemon = 0;
+	std::vector<int> expectedPokemons;
+
+	switch (command->type) {
+	case (INIT_CMD):
+		if (command->res == SUCCESS) {
+			model.clear();
+			modelInit = true;
+		};
+		return error_free;
+	case (QUIT_CMD):
+		model.clear();
+		modelInit = false;
+		return error_free;
+	default:
+		break;
+	};
+	if (modelInit) {
+		switch (command->type) {
+		case (ADDTRAINER_CMD):
+			expected = model.addTrainer(args[0]);
+			break;
+		case (CatchPokemon_CMD):
+			expected = model.catchPokemon(args[0], args[1], args[2]);
+			break;
+		case (REMOVEPOKEMON_CMD):
+			expected = model.freePokemon(args[0]);
+			break;
+		case (INCREASE_CMD):
+			expected = model.levelUp(args[0], args[1]);
+			break;
+		case (EVOLVE_CMD):
+			expected = model.evolvePokemon(args[0], args[1]);
+			break;
+		case (GETTOPPOKEMON_CMD):
+			expected = model.getTopPokemon(args[0], &expectedPokemon);
+			break;
+		case (GETALLPOKEMONS_CMD):
+			expected = model.getAllPokemonsByLevel(args[0], expectedPokemons);
+			break;
+		case (UPDATE_CMD):
+			expected = model.updateLevels(args[0], args[1]);
+			break;
+		default:
+			assert(false);
+			break;
+		};
+	};
+
+	if (command->res != expected) {
+		ReportMismatch(command, "returned", command->res, expected);
+		return error;
+	};
+	if (expected != SUCCESS)
+		return error_free;
+	if (command->type == GETTOPPOKEMON_CMD
+			&& command->pokemonID != expectedPokemon) {
+		ReportMismatch(command, "top pokemon", command->pokemonID,
+				expectedPokemon);
+		return error;
+	};
+	if (command->type == GETALLPOKEMONS_CMD) {
+		if ((size_t) command->numOfPokemons != expectedPokemons.size()) {
+			ReportMismatch(command, "number of pokemons",
+					command->numOfPokemons, expectedPokemons.size());
+			return error;
+		};
+		for (int i = 0; i < command->numOfPokemons; i++) {
+			if (command->pokemons[i] != expectedPokemons[i]) {
+				fprintf(stderr, "verify: pokemon %d of the list differs\n",
+						i + 1);
+				ReportMismatch(command, "pokemon", command->pokemons[i],
+						expectedPokemons[i]);
+				return error;
+			};
+		};
+	};
+	return error_free;
+}
+
+/***************************************************************************/
+/* Input                                                                   */
+/***************************************************************************/
+
+/* Handle one command line, or one parsed command. Return error to stop
+ * reading. */
+typedef errorType (*LineHandler)(const char* const line);
+typedef errorType (*CommandHandler)(Command* command);
+
+static errorType RunCommand(Command* command) {
+	errorType rtn_val = ExecuteTimed(command);
+	if (VerifyCommand(command) == error)
+		rtn_val = error;
+	OutputCommand(command);
+	if (interactive)
+		OutFlush();
+	return rtn_val;
+}
+
+/* Reads the commands from stdin, one line of up to MAX_STRING_INPUT_SIZE
+ * characters at a time. */
+static void RunStdin(LineHandler handleLine) {
 	char buffer[MAX_STRING_INPUT_SIZE];
 
-	// Reading commands
 	while (fgets(buffer, MAX_STRING_INPUT_SIZE, stdin) != NULL) {
-		fflush(stdout);
-		if (parser(buffer) == error)
+		if (handleLine(buffer) == error)
+			break;
+	};
+}
+
+/* Maps a whole file for reading. Prints why and returns NULL if it can't.
+ * An empty file isn't mapped, it gets an empty range. */
+static const char* MapFile(const char* path, size_t* size) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		perror(path);
+		return NULL;
+	};
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		perror(path);
+		close(fd);
+		return NULL;
+	};
+	*size = info.st_size;
+	if (*size == 0) {
+		close(fd);
+		return "";
+	};
+	void* data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		perror(path);
+		return NULL;
+	};
+	madvise(data, *size, MADV_SEQUENTIAL);
+	return (const char*) data;
+}
+
+static void UnmapFile(const char* data, size_t size) {
+	if (size > 0)
+		munmap((void*) data, size);
+}
+
+/* Maps a command file and parses the commands directly from the mapping.
+ * The parser reads a line up to its '\n', so lines have no length limit;
+ * only a last line without a '\n' is copied out, to NUL-terminate it. */
+static bool RunMapped(const char* path, LineHandler handleLine) {
+	size_t size;
+	const char* data = MapFile(path, &size);
+	if (data == NULL)
+		return false;
+
+	const char* line = data;
+	const char* end = data + size;
+	while (line < end) {
+		const char* newline = (const char*) memchr(line, '\n', end - line);
+		if (newline == NULL) {
+			size_t length = end - line;
+			char* lastLine = (char*) malloc(length + 1);
+			if (lastLine == NULL) {
+				fprintf(stderr, "%s: out of memory\n", path);
+				break;
+			};
+			memcpy(lastLine, line, length);
+			lastLine[length] = '\0';
+			handleLine(lastLine);
+			free(lastLine);
+			break;
+		};
+		if (handleLine(line) == error)
+			break;
+		line = newline + 1;
+	};
+	UnmapFile(data, size);
+	return true;
+}
+
+/***************************************************************************/
+/* Binary Input                                                            */
+/***************************************************************************/
+
+/* Binary commands (-b, see binaryProtocol.h) are decoded straight into
+ * Commands, from a mapped file or from stdin read in large chunks. */
+#define BINARY_READ_SIZE (1 << 16)
+
+typedef struct {
+	const char* data; /* The unread input is data[start, end) */
+	size_t start;
+	size_t end;
+	char* buffer; /* Reading stdin: the buffer data points to */
+	size_t capacity;
+	bool reading; /* stdin may have more input */
+} BinaryInput;
+
+/* Makes length bytes of input available at data + start, reading more of
+ * stdin if needed. Returns false if the input ends first. */
+static bool BinaryFill(BinaryInput* input, size_t length) {
+	while (input->end - input->start < length) {
+		if (!input->reading)
+			return false;
+		size_t pending = input->end - input->start;
+		memmove(input->buffer, input->buffer + input->start, pending);
+		input->start = 0;
+		input->end = pending;
+		if (input->capacity - pending < BINARY_READ_SIZE
+				|| input->capacity < length) {
+			size_t capacity = 2 * input->capacity + length + BINARY_READ_SIZE;
+			char* buffer = (char*) realloc(input->buffer, capacity);
+			if (buffer == NULL) {
+				fprintf(stderr, "out of memory\n");
+				input->reading = false;
+				return false;
+			};
+			input->buffer = buffer;
+			input->capacity = capacity;
+			input->data = buffer;
+		};
+		ssize_t bytesRead = read(STDIN_FILENO, input->buffer + input->end,
+				input->capacity - input->end);
+		if (bytesRead < 0 && errno == EINTR)
+			continue;
+		if (bytesRead <= 0) {
+			input->reading = false;
+			continue;
+		};
+		input->end += bytesRead;
+	};
+	return true;
+}
+
+static void InitCommand(Command* command, commandType type) {
+	command->type = type;
+	command->numOfArgs = 0;
+	command->text = NULL;
+	command->textLength = 0;
+	command->ownsText = false;
+	command->pokemons = NULL;
+	command->numOfPokemons = 0;
+}
+
+/* Decodes the next record. An unknown opcode becomes NONE_CMD, which stops
+ * the shell like an unknown text command does, and a record cut short by
+ * the end of the input keeps the arguments read so far, failing like a
+ * malformed text command. Returns false at the end of the input. */
+static bool NextBinaryCommand(BinaryInput* input, Command* command) {
+	if (!BinaryFill(input, 1))
+		return false;
+	int op = (unsigned char) input->data[input->start++];
+	int numOfArgs = BinaryOpArgs(op);
+	if (numOfArgs < 0) {
+		InitCommand(command, NONE_CMD);
+		return true;
+	};
+	if (op == BINARY_COMMENT) {
+		int32_t length;
+		InitCommand(command, NONE_CMD);
+		if (!BinaryFill(input, sizeof(length)))
+			return true;
+		memcpy(&length, input->data + input->start, sizeof(length));
+		input->start += sizeof(length);
+		if (length < 0 || !BinaryFill(input, length))
+			return true;
+		command->type = COMMENT_CMD;
+		command->text = input->data + input->start;
+		command->textLength = length;
+		input->start += length;
+		return true;
+	};
+
+	// the opcodes of the commands follow commandType's order
+	InitCommand(command, (commandType) (op - BINARY_INIT));
+	while (command->numOfArgs < numOfArgs
+			&& BinaryFill(input, sizeof(int32_t))) {
+		int32_t value;
+		memcpy(&value, input->data + input->start, sizeof(value));
+		input->start += sizeof(value);
+		command->args[command->numOfArgs++] = value;
+	};
+	return true;
+}
+
+/* Runs the binary commands of a file, or of stdin if path is NULL. */
+static bool RunBinary(const char* path, CommandHandler handleCommand) {
+	BinaryInput input;
+	memset(&input, 0, sizeof(input));
+	size_t size = 0;
+	if (path != NULL) {
+		input.data = MapFile(path, &size);
+		if (input.data == NULL)
+			return false;
+		input.end = size;
+	} else {
+		input.reading = true;
+	};
+
+	bool ok = BinaryFill(&input, BINARY_MAGIC_SIZE)
+			&& memcmp(input.data + input.start, BINARY_MAGIC,
+					BINARY_MAGIC_SIZE) == 0;
+	if (ok) {
+		input.start += BINARY_MAGIC_SIZE;
+		Command command;
+		while (NextBinaryCommand(&input, &command)) {
+			if (handleCommand(&command) == error)
+				break;
+		};
+	} else {
+		fprintf(stderr, "%s: not a binary command stream\n",
+				path != NULL ? path : "stdin");
+	};
+
+	if (path != NULL)
+		UnmapFile(input.data, size);
+	free(input.buffer);
+	return ok;
+}
+
+/***************************************************************************/
+/* Pipeline                                                                */
+/***************************************************************************/
+
+/* The pipelined shell (-p) runs in three threads: the reader reads the input
+ * and parses it into Commands, the executor runs them against the DS (the
+ * only thread touching it), and the main thread prints them. The threads
+ * hand the Commands over through two SpscRings, so reading, parsing and
+ * printing overlap with executing. The output is the same as the serial
+ * shell's, including stopping at the first command that stops it. */
+#define PIPELINE_RING_SIZE (4096)
+
+static SpscRing<Command>* parsedCommands = NULL;   /* reader -> executor */
+static SpscRing<Command>* executedCommands = NULL; /* executor -> printer */
+static std::atomic<bool> stopReading(false);
+static const char* inputPath = NULL;
+static bool binaryInput = false;
+static bool inputOk = true;
+
+/* Commands that stop the shell before they are executed */
+static bool StopsBeforeExecuting(const Command* command) {
+	return command->type == NONE_CMD
+			|| (command->type >= 0
+					&& command->numOfArgs < commandArgs[command->type]);
+}
+
+static errorType PushCommand(Command* command) {
+	// the input is gone once the next command is read, keep the comment's text
+	if (command->textLength > 0) {
+		char* text = (char*) malloc(command->textLength);
+		if (text != NULL)
+			memcpy(text, command->text, command->textLength);
+		command->text = text;
+		command->textLength = (text != NULL) ? command->textLength : 0;
+		command->ownsText = (text != NULL);
+	};
+	parsedCommands->push(*command);
+	if (StopsBeforeExecuting(command))
+		return error;
+	return stopReading.load(std::memory_order_relaxed) ? error : error_free;
+}
+
+static errorType ReadCommand(const char* const line) {
+	Command command;
+	ParseCommand(line, &command);
+	return PushCommand(&command);
+}
+
+static void* ReaderThread(void*) {
+	if (binaryInput) {
+		inputOk = RunBinary(inputPath, PushCommand);
+	} else if (inputPath != NULL) {
+		inputOk = RunMapped(inputPath, ReadCommand);
+	} else {
+		RunStdin(ReadCommand);
+	};
+	Command end;
+	end.type = END_CMD;
+	parsedCommands->push(end);
+	return NULL;
+}
+
+static void* ExecutorThread(void*) {
+	Command command;
+	bool stopped = false;
+	for (;;) {
+		parsedCommands->pop(command);
+		if (command.type == END_CMD)
+			break;
+		if (stopped) {
+			// drain the commands read before the reader saw stopReading
+			DiscardCommand(&command);
+			continue;
+		};
+		errorType rtn_val = ExecuteTimed(&command);
+		if (VerifyCommand(&command) == error)
+			rtn_val = error;
+		if (rtn_val == error) {
+			stopped = true;
+			stopReading.store(true, std::memory_order_relaxed);
+		};
+		executedCommands->push(command);
+	};
+	executedCommands->push(command);
+	return NULL;
+}
+
+static bool RunPipelined() {
+	SpscRing<Command> parsed(PIPELINE_RING_SIZE);
+	SpscRing<Command> executed(PIPELINE_RING_SIZE);
+	parsedCommands = &parsed;
+	executedCommands = &executed;
+
+	pthread_t reader, executor;
+	if (pthread_create(&reader, NULL, ReaderThread, NULL) != 0) {
+		fprintf(stderr, "can't start the reader thread\n");
+		return false;
+	};
+	if (pthread_create(&executor, NULL, ExecutorThread, NULL) != 0) {
+		fprintf(stderr, "can't start the executor thread\n");
+		stopReading.store(true, std::memory_order_relaxed);
+		Command command;
+		do {
+			parsed.pop(command);
+			DiscardCommand(&command);
+		} while (command.type != END_CMD);
+		pthread_join(reader, NULL);
+		return false;
+	};
+
+	Command command;
+	for (;;) {
+		executedCommands->pop(command);
+		if (command.type == END_CMD)
+			break;
+		OutputCommand(&command);
+		if (interactive)
+			OutFlush();
+	};
+	pthread_join(executor, NULL);
+	pthread_join(reader, NULL);
+	return inputOk;
+}
+
+/***************************************************************************/
+/* Server                                                                  */
+/***************************************************************************/
+
+/* The server (-s) listens on a Unix socket and serves any number of clients
+ * from one thread with epoll. Every connection is a shell of its own: it
+ * speaks the text commands, or the binary ones if it starts with
+ * BINARY_MAGIC, and stops at the first command that stops the shell, after
+ * which its output is sent and it is closed. All the connections share the
+ * one DS, so a client sees the others' changes, and their commands never
+ * interleave within a batch. The DS belongs to the server, which runs Init
+ * before it accepts clients and Quit once it stops: a client's Init is
+ * answered "Init was already called." without running, and a client's Quit
+ * ends only its own connection.
+ * A client may pipeline: everything one read brings is executed in order,
+ * and the responses are sent together in one write. A connection whose
+ * client doesn't read its output isn't read from either until it does. */
+#define SERVER_READ_SIZE (1 << 16)
+#define SERVER_MAX_EVENTS (256)
+#define SERVER_MAX_REQUEST (1 << 20)   /* The longest line or record */
+#define SERVER_OUTPUT_LIMIT (1 << 22)  /* Unsent output that pauses input */
+
+typedef enum {
+	PROTOCOL_UNKNOWN, PROTOCOL_TEXT, PROTOCOL_BINARY
+} Protocol;
+
+typedef struct Connection {
+	int fd;
+	uint32_t events;  /* What epoll waits for */
+	Protocol protocol;
+	char* input;      /* The unread input is input[inputStart, inputEnd) */
+	size_t inputStart;
+	size_t inputEnd;
+	size_t inputCapacity;
+	bool eof;         /* The client sent all its input */
+	bool stopped;     /* A command stopped the connection's shell */
+	OutputBuffer output;
+	size_t outputSent;
+	struct Connection* prev;
+	struct Connection* next;
+} Connection;
+
+static Connection* connections = NULL;
+static volatile sig_atomic_t serverStopping = 0;
+
+static void StopServer(int) {
+	serverStopping = 1;
+}
+
+/* The length of the binary record at data, or 0 if it is longer than the
+ * available bytes. Records NextBinaryCommand turns into NONE_CMD are only
+ * as long as what it reads of them. */
+static size_t BinaryRecordLength(const char* data, size_t available) {
+	if (available < 1)
+		return 0;
+	int op = (unsigned char) data[0];
+	int numOfArgs = BinaryOpArgs(op);
+	size_t length = 1;
+	if (numOfArgs < 0)
+		return length;
+	if (op == BINARY_COMMENT) {
+		int32_t textLength;
+		length += sizeof(textLength);
+		if (available < length)
+			return 0;
+		memcpy(&textLength, data + 1, sizeof(textLength));
+		if (textLength > 0)
+			length += textLength;
+	} else {
+		length += numOfArgs * sizeof(int32_t);
+	};
+	return available < length ? 0 : length;
+}
+
+/* Parses the next complete command of a connection's input. Once the client
+ * sent everything, a last line without a '\n' or a record cut short is
+ * parsed as it is, like the end of a command file. Returns false if there
+ * is no command to run yet. */
+static bool NextServerCommand(Connection* connection, Command* command) {
+	char* data = connection->input + connection->inputStart;
+	size_t available = connection->inputEnd - connection->inputStart;
+	if (available == 0)
+		return false;
+
+	if (connection->protocol == PROTOCOL_UNKNOWN) {
+		if (available < BINARY_MAGIC_SIZE && !connection->eof
+				&& memcmp(data, BINARY_MAGIC, available) == 0)
+			return false;
+		if (available >= BINARY_MAGIC_SIZE
+				&& memcmp(data, BINARY_MAGIC, BINARY_MAGIC_SIZE) == 0) {
+			connection->protocol = PROTOCOL_BINARY;
+			connection->inputStart += BINARY_MAGIC_SIZE;
+			return NextServerCommand(connection, command);
+		};
+		connection->protocol = PROTOCOL_TEXT;
+	};
+
+	size_t length;
+	if (connection->protocol == PROTOCOL_TEXT) {
+		const char* newline = (const char*) memchr(data, '\n', available);
+		if (newline != NULL) {
+			length = newline - data + 1;
+		} else if (connection->eof) {
+			// the input buffer keeps a spare byte for the NUL
+			data[available] = '\0';
+			length = available;
+		} else {
+			return false;
+		};
+		ParseCommand(data, command);
+	} else {
+		length = BinaryRecordLength(data, available);
+		if (length == 0) {
+			if (!connection->eof)
+				return false;
+			length = available;
+		};
+		BinaryInput input;
+		memset(&input, 0, sizeof(input));
+		input.data = data;
+		input.end = length;
+		NextBinaryCommand(&input, command);
+	};
+	connection->inputStart += length;
+	return true;
+}
+
+static size_t UnsentOutput(const Connection* connection) {
+	return connection->output.used - connection->outputSent;
+}
+
+/* Answers a client's Init or Quit, which must not reach the shared DS */
+static void ServeSessionCommand(Connection* connection, Command* command) {
+	if (command->type == INIT_CMD) {
+		command->res = FAILURE;
+	} else {
+		command->res = SUCCESS;
+		connection->stopped = true;
+	};
+	OutputCommand(command);
+}
+
+/* Runs the connection's complete commands, into its output buffer */
+static void ServeCommands(Connection* connection) {
+	output = &connection->output;
+	Command command;
+	while (!connection->stopped
+			&& UnsentOutput(connection) < SERVER_OUTPUT_LIMIT
+			&& NextServerCommand(connection, &command)) {
+		if (command.type == INIT_CMD || command.type == QUIT_CMD)
+			ServeSessionCommand(connection, &command);
+		else if (RunCommand(&command) == error)
+			connection->stopped = true;
+	};
+	output = &stdoutBuffer;
+
+	if (connection->output.failed && !connection->stopped) {
+		fprintf(stderr, "server: out of memory for a connection's output\n");
+		connection->stopped = true;
+	};
+	if (!connection->stopped && connection->inputEnd - connection->inputStart
+			> SERVER_MAX_REQUEST) {
+		fprintf(stderr, "server: a request is longer than %d bytes\n",
+				SERVER_MAX_REQUEST);
+		connection->stopped = true;
+	};
+}
+
+/* Reads what the client sent, up to SERVER_READ_SIZE bytes. Returns false
+ * if the connection broke. */
+static bool ReadConnection(Connection* connection) {
+	size_t pending = connection->inputEnd - connection->inputStart;
+	if (connection->inputStart > 0)
+		memmove(connection->input, connection->input + connection->inputStart,
+				pending);
+	connection->inputStart = 0;
+	connection->inputEnd = pending;
+	if (connection->inputCapacity - pending < SERVER_READ_SIZE + 1) {
+		size_t capacity = 2 * connection->inputCapacity + SERVER_READ_SIZE + 1;
+		char* input = (char*) realloc(connection->input, capacity);
+		if (input == NULL) {
+			fprintf(stderr, "server: out of memory for a connection's input\n");
+			return false;
+		};
+		connection->input = input;
+		connection->inputCapacity = capacity;
+	};
+
+	ssize_t bytesRead;
+	do {
+		bytesRead = read(connection->fd, connection->input + pending,
+				connection->inputCapacity - pending - 1);
+	} while (bytesRead < 0 && errno == EINTR);
+	if (bytesRead < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK;
+	if (bytesRead == 0)
+		connection->eof = true;
+	connection->inputEnd += bytesRead;
+	return true;
+}
+
+/* Sends as much of the output as the socket takes. Returns false if the
+ * connection broke. */
+static bool SendOutput(Connection* connection) {
+	OutputBuffer* buffer = &connection->output;
+	while (connection->outputSent < buffer->used) {
+		ssize_t sent = send(connection->fd, buffer->data + connection->outputSent,
+				buffer->used - connection->outputSent, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK;
+		connection->outputSent += sent;
+	};
+	buffer->used = 0;
+	connection->outputSent = 0;
+	if (buffer->capacity > SERVER_OUTPUT_LIMIT) {
+		// give back what a long GetAllPokemonsByLevel list took
+		free(buffer->data);
+		buffer->data = NULL;
+		buffer->capacity = 0;
+	};
+	return true;
+}
+
+static void CloseConnection(Connection* connection) {
+	if (connection->prev != NULL)
+		connection->prev->next = connection->next;
+	else
+		connections = connection->next;
+	if (connection->next != NULL)
+		connection->next->prev = connection->prev;
+	close(connection->fd);
+	free(connection->input);
+	free(connection->output.data);
+	free(connection);
+}
+
+/* Runs what the connection can run, sends the output, and waits for what
+ * it needs next, or closes it once it is done. */
+static void UpdateConnection(int epollFd, Connection* connection) {
+	ServeCommands(connection);
+	if (!SendOutput(connection)) {
+		CloseConnection(connection);
+		return;
+	};
+	bool done = connection->stopped || (connection->eof
+			&& connection->inputStart == connection->inputEnd);
+	if (done && UnsentOutput(connection) == 0) {
+		CloseConnection(connection);
+		return;
+	};
+
+	uint32_t events = 0;
+	if (!done && !connection->eof
+			&& UnsentOutput(connection) < SERVER_OUTPUT_LIMIT)
+		events |= EPOLLIN;
+	if (UnsentOutput(connection) > 0)
+		events |= EPOLLOUT;
+	if (events != connection->events) {
+		struct epoll_event event;
+		event.events = events;
+		event.data.ptr = connection;
+		if (epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event) != 0) {
+			perror("epoll_ctl");
+			CloseConnection(connection);
+			return;
+		};
+		connection->events = events;
+	};
+}
+
+static void AcceptConnections(int epollFd, int listenFd) {
+	for (;;) {
+		int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				perror("accept");
+			return;
+		};
+		Connection* connection = (Connection*) calloc(1, sizeof(Connection));
+		if (connection == NULL) {
+			fprintf(stderr, "server: out of memory for a connection\n");
+			close(fd);
+			continue;
+		};
+		connection->fd = fd;
+		connection->events = EPOLLIN;
+		connection->output.growable = true;
+		struct epoll_event event;
+		event.events = connection->events;
+		event.data.ptr = connection;
+		if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+			perror("epoll_ctl");
+			close(fd);
+			free(connection);
+			continue;
+		};
+		connection->next = connections;
+		if (connections != NULL)
+			connections->prev = connection;
+		connections = connection;
+	};
+}
+
+/* Listens on a Unix socket at path, replacing a socket left there, until
+ * SIGINT or SIGTERM. Returns false if it can't. */
+static bool RunServer(const char* path) {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "%s: socket path too long\n", path);
+		return false;
+	};
+	strcpy(address.sun_path, path);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = StopServer;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+			0);
+	if (listenFd < 0) {
+		perror("socket");
+		return false;
+	};
+	struct stat info;
+	if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode))
+		unlink(path);
+	if (bind(listenFd, (struct sockaddr*) &address, sizeof(address)) != 0
+			|| listen(listenFd, SOMAXCONN) != 0) {
+		perror(path);
+		close(listenFd);
+		return false;
+	};
+	int epollFd = epoll_create1(EPOLL_CLOEXEC);
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	if (epollFd < 0
+			|| epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0) {
+		perror("epoll");
+		if (epollFd >= 0)
+			close(epollFd);
+		close(listenFd);
+		unlink(path);
+		return false;
+	};
+	// the DS outlives every client, see ServeSessionCommand
+	Command session;
+	InitCommand(&session, INIT_CMD);
+	if (RunCommand(&session) == error) {
+		close(epollFd);
+		close(listenFd);
+		unlink(path);
+		return false;
+	};
+	fprintf(stderr, "listening on %s\n", path);
+
+	bool ok = true;
+	struct epoll_event events[SERVER_MAX_EVENTS];
+	while (!serverStopping) {
+		int ready = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, -1);
+		if (ready < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("epoll_wait");
+			ok = false;
 			break;
+		};
+		for (int i = 0; i < ready; i++) {
+			Connection* connection = (Connection*) events[i].data.ptr;
+			if (connection == NULL) {
+				AcceptConnections(epollFd, listenFd);
+				continue;
+			};
+			if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+					&& (connection->events & EPOLLIN)
+					&& !ReadConnection(connection)) {
+				CloseConnection(connection);
+				continue;
+			};
+			UpdateConnection(epollFd, connection);
+		};
 	};
-	return 0;
+
+	while (connections != NULL)
+		CloseConnection(connections);
+	InitCommand(&session, QUIT_CMD);
+	RunCommand(&session);
+	close(epollFd);
+	close(listenFd);
+	unlink(path);
+	return ok;
+}
+
+/***************************************************************************/
+/* main                                                                    */
+/***************************************************************************/
+int main(int argc, const char**argv) {
+	const char* path = NULL;
+	bool forceInteractive = false;
+	bool pipelined = false;
+	const char* socketPath = NULL;
+	bool badUsage = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-i") == 0) {
+			forceInteractive = true;
+		} else if (strcmp(argv[i], "-p") == 0) {
+			pipelined = true;
+		} else if (strcmp(argv[i], "-b") == 0) {
+			binaryInput = true;
+		} else if (strcmp(argv[i], "-B") == 0) {
+			benchmark = true;
+		} else if (strcmp(argv[i], "-V") == 0) {
+			verify = true;
+		} else if (strcmp(argv[i], "-q") == 0) {
+			quiet = true;
+		} else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			socketPath = argv[++i];
+		} else if (path == NULL && argv[i][0] != '-') {
+			path = argv[i];
+		} else {
+			badUsage = true;
+		};
+	};
+	// the server reads sockets only, and flushes after every batch anyway
+	if (socketPath != NULL && (path != NULL || pipelined || binaryInput
+			|| forceInteractive))
+		badUsage = true;
+	if (badUsage) {
+		fprintf(stderr, "usage: %s [-i] [-p] [-b] [-B] [-V] [-q] [command file]\n"
+				"       %s -s socket [-B] [-V] [-q]\n", argv[0], argv[0]);
+		return 1;
+	};
+	interactive = socketPath == NULL
+			&& (forceInteractive || (path == NULL && isatty(STDIN_FILENO)));
+
+	std::chrono::steady_clock::time_point runStart =
+			std::chrono::steady_clock::now();
+	uint64_t runStartTicks = ReadClock();
+
+	// Reading commands
+	bool ok = true;
+	if (socketPath != NULL) {
+		ok = RunServer(socketPath);
+	} else if (pipelined) {
+		inputPath = path;
+		ok = RunPipelined();
+	} else if (binaryInput) {
+		ok = RunBinary(path, RunCommand);
+	} else if (path != NULL) {
+		ok = RunMapped(path, parser);
+	} else {
+		RunStdin(parser);
+	};
+	if (quiet)
+		PrintStatusCounts();
+	if (benchmark)
+		PrintLatencies(ReadClock() - runStartTicks,
+				std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - runStart).count());
+	OutFlush();
+	if (verify && !verifyFailed)
+		fprintf(stderr, "verify: %lld commands match the reference model\n",
+				verifiedCommands);
+	return (ok && !verifyFailed) ? 0 : 1;
 }
 
 /***************************************************************************/
 /* Command Checker                                                         */
 /***************************************************************************/
 
+/* The commands grouped by their first character: firstCommand[c] is the
+ * first command starting with c, and nextCommand chains the rest in
+ * commandStr order. Built from commandStr on first use, so adding a command
+ * only takes adding its string. */
+static int firstCommand[256];
+static int nextCommand[numActions];
+static size_t commandLength[numActions];
+static bool commandTableReady = false;
+
+static void BuildCommandTable() {
+	for (int c = 0; c < 256; c++) {
+		firstCommand[c] = -1;
+	}
+	for (int index = numActions - 1; index >= 0; index--) {
+		unsigned char first = (unsigned char) commandStr[index][0];
+		commandLength[index] = strlen(commandStr[index]);
+		nextCommand[index] = firstCommand[first];
+		firstCommand[first] = index;
+	}
+	commandTableReady = true;
+}
+
 static commandType CheckCommand(const char* const command,
 		const char** const command_arg) {
-	if (command == NULL || strlen(command) == 0 || StrCmp("\n", command))
+	if (command == NULL || command[0] == '\0' || command[0] == '\n')
 		return (NONE_CMD);
-	if (StrCmp("#", command)) {
-		if (strlen(command) > 1)
-			printf("%s", command);
+	if (command[0] == '#')
 		return (COMMENT_CMD);
-	};
-	for (int index = 0; index < numActions; index++) {
-		if (StrCmp(commandStr[index], command)) {
-			*command_arg = command + strlen(commandStr[index]) + 1;
+	if (!commandTableReady)
+		BuildCommandTable();
+	for (int index = firstCommand[(unsigned char) command[0]]; index >= 0;
+			index = nextCommand[index]) {
+		if (strncmp(commandStr[index] + 1, command + 1,
+				commandLength[index] - 1) == 0) {
+			// skip the separator after the name, but never the end of the line
+			const char* arg = command + commandLength[index];
+			*command_arg = (*arg == '\0' || *arg == '\n') ? arg : arg + 1;
 			return ((commandType) index);
 		};
 	};
@@ -120,59 +1359,84 @@ static commandType CheckCommand(const char* const command,
 /* Commands Functions                                                      */
 /***************************************************************************/
 
-static errorType OnInit(void** DS, const char* const command);
-static errorType OnAddTrainer(void* DS, const char* const command);
-static errorType OnCatchPokemon(void* DS, const char* const command);
-static errorType OnFreePokemon(void* DS, const char* const command);
-static errorType OnLevelUp(void* DS, const char* const command);
-static errorType OnEvolvePokemon(void* DS, const char* const command);
-static errorType OnGetTopPokemon(void* DS, const char* const command);
-static errorType OnGetAllPokemonsByLevel(void* DS, const char* const command);
-static errorType OnUpdateLevels(void* DS, const char* const command);
-static errorType OnQuit(void** DS, const char* const command);
+static errorType OnInit(void** DS, Command* command);
+static errorType OnAddTrainer(void* DS, Command* command);
+static errorType OnCatchPokemon(void* DS, Command* command);
+static errorType OnFreePokemon(void* DS, Command* command);
+static errorType OnLevelUp(void* DS, Command* command);
+static errorType OnEvolvePokemon(void* DS, Command* command);
+static errorType OnGetTopPokemon(void* DS, Command* command);
+static errorType OnGetAllPokemonsByLevel(void* DS, Command* command);
+static errorType OnUpdateLevels(void* DS, Command* command);
+static errorType OnQuit(void** DS, Command* command);
 
 /***************************************************************************/
 /* Parser                                                                  */
 /***************************************************************************/
 
 static errorType parser(const char* const command) {
-	static void *DS = NULL; /* The general data structure */
+	Command parsed;
+	ParseCommand(command, &parsed);
+	return RunCommand(&parsed);
+}
+
+static void ParseCommand(const char* const line, Command* command) {
 	const char* command_args = NULL;
+
+	InitCommand(command, CheckCommand(line, &command_args));
+
+	if (command->type == COMMENT_CMD) {
+		if (line[1] != '\0') {
+			size_t length = strcspn(line, "\n");
+			command->text = line;
+			command->textLength = (line[length] == '\n') ? length + 1 : length;
+		};
+	} else if (command->type >= 0) {
+		// ReadInts returns fewer than commandArgs if the line is malformed,
+		// ExecuteCommand then fails the command
+		command->numOfArgs = ReadInts(command_args, command->args,
+				commandArgs[command->type]);
+	};
+}
+
+static errorType ExecuteCommand(Command* command) {
+	static void *DS = NULL; /* The general data structure */
 	errorType rtn_val = error;
 
-	commandType command_val = CheckCommand(command, &command_args);
+	if (command->type >= 0 && command->numOfArgs < commandArgs[command->type])
+		return (error);
 
-	switch (command_val) {
+	switch (command->type) {
 
 	case (INIT_CMD):
-		rtn_val = OnInit(&DS, command_args);
+		rtn_val = OnInit(&DS, command);
 		break;
 	case (ADDTRAINER_CMD):
-		rtn_val = OnAddTrainer(DS, command_args);
+		rtn_val = OnAddTrainer(DS, command);
 		break;
 	case (CatchPokemon_CMD):
-		rtn_val = OnCatchPokemon(DS, command_args);
+		rtn_val = OnCatchPokemon(DS, command);
 		break;
 	case (REMOVEPOKEMON_CMD):
-		rtn_val = OnFreePokemon(DS, command_args);
+		rtn_val = OnFreePokemon(DS, command);
 		break;
 	case (INCREASE_CMD):
-		rtn_val = OnLevelUp(DS, command_args);
+		rtn_val = OnLevelUp(DS, command);
 		break;
 	case (EVOLVE_CMD):
-		rtn_val = OnEvolvePokemon(DS, command_args);
+		rtn_val = OnEvolvePokemon(DS, command);
 		break;
 	case (GETTOPPOKEMON_CMD):
-		rtn_val = OnGetTopPokemon(DS, command_args);
+		rtn_val = OnGetTopPokemon(DS, command);
 		break;
 	case (GETALLPOKEMONS_CMD):
-		rtn_val = OnGetAllPokemonsByLevel(DS, command_args);
+		rtn_val = OnGetAllPokemonsByLevel(DS, command);
 		break;
 	case (UPDATE_CMD):
-		rtn_val = OnUpdateLevels(DS, command_args);
+		rtn_val = OnUpdateLevels(DS, command);
 		break;
 	case (QUIT_CMD):
-		rtn_val = OnQuit(&DS, command_args);
+		rtn_val = OnQuit(&DS, command);
 		break;
 
 	case (COMMENT_CMD):
@@ -188,22 +1452,82 @@ static errorType parser(const char* const command) {
 	return (rtn_val);
 }
 
+/***************************************************************************/
+/* Printer                                                                 */
+/***************************************************************************/
+
+static void PrintAll(int *pokemons, int numOfPokemons);
+
+static void PrintCommand(Command* command) {
+	if (command->type == COMMENT_CMD) {
+		OutWrite(command->text, command->textLength);
+		if (command->ownsText)
+			free((void*) command->text);
+		return;
+	};
+	if (command->type < 0)
+		return;
+	const char* name = commandStr[command->type];
+	if (command->numOfArgs < commandArgs[command->type]) {
+		OutPrintf("%s failed.\n", name);
+		return;
+	};
+
+	switch (command->type) {
+	case (INIT_CMD):
+		if (command->res == FAILURE)
+			OutPrintf("Init was already called.\n");
+		else if (command->res != SUCCESS)
+			OutPrintf("Init failed.\n");
+		else
+			OutPrintf("Init done.\n");
+		break;
+	case (QUIT_CMD):
+		OutPrintf(command->res == SUCCESS ? "Quit done.\n" : "Quit failed.\n");
+		break;
+	case (GETTOPPOKEMON_CMD):
+		if (command->res != SUCCESS) {
+			OutPrintf("%s: %s\n", name, ReturnValToStr(command->res));
+			break;
+		};
+		OutPrintf("Pokemon with highest level is: %d\n", command->pokemonID);
+		break;
+	case (GETALLPOKEMONS_CMD):
+		if (command->res != SUCCESS) {
+			OutPrintf("%s: %s\n", name, ReturnValToStr(command->res));
+			break;
+		};
+		PrintAll(command->pokemons, command->numOfPokemons);
+		break;
+	default:
+		OutPrintf("%s: %s\n", name, ReturnValToStr(command->res));
+		break;
+	};
+}
+
+/* Releases what a command holds without printing it */
+static void DiscardCommand(Command* command) {
+	if (command->ownsText)
+		free((void*) command->text);
+	free(command->pokemons);
+}
+
 /***************************************************************************/
 /* OnInit                                                                  */
 /***************************************************************************/
-static errorType OnInit(void** DS, const char* const command) {
+static errorType OnInit(void** DS, Command* command) {
 	if (isInit) {
-		printf("Init was already called.\n");
+		command->res = FAILURE;
 		return (error_free);
 	};
 	isInit = true;
 
 	*DS = Init();
 	if (*DS == NULL) {
-		printf("Init failed.\n");
+		command->res = ALLOCATION_ERROR;
 		return error;
 	};
-	printf("Init done.\n");
+	command->res = SUCCESS;
 
 	return error_free;
 }
@@ -211,113 +1535,58 @@ static errorType OnInit(void** DS, const char* const command) {
 /***************************************************************************/
 /* OnAddTrainer                                                             */
 /***************************************************************************/
-static errorType OnAddTrainer(void* DS, const char* const command) {
-	int trainerID;
-	ValidateRead(sscanf(command, "%d", &trainerID), 1, "AddTrainer failed.\n");
-	StatusType res = AddTrainer(DS, trainerID);
-
-	if (res != SUCCESS) {
-		printf("AddTrainer: %s\n", ReturnValToStr(res));
-		return error_free;
-	} else {
-		printf("AddTrainer: %s\n", ReturnValToStr(res));
-	}
-
+static errorType OnAddTrainer(void* DS, Command* command) {
+	int trainerID = command->args[0];
+	command->res = AddTrainer(DS, trainerID);
 	return error_free;
 }
 
 /***************************************************************************/
 /* OnCatchPokemon                                                          */
 /***************************************************************************/
-static errorType OnCatchPokemon(void* DS, const char* const command) {
-	int pokemonID;
-	int trainerID;
-	int level;
-	ValidateRead(
-			sscanf(command, "%d %d %d", &pokemonID, &trainerID, &level),
-			3, "CatchPokemon failed.\n");
-	StatusType res = CatchPokemon(DS, pokemonID, trainerID, level);
-
-	if (res != SUCCESS) {
-		printf("CatchPokemon: %s\n", ReturnValToStr(res));
-		return error_free;
-	}
-
-	printf("CatchPokemon: %s\n", ReturnValToStr(res));
+static errorType OnCatchPokemon(void* DS, Command* command) {
+	int pokemonID = command->args[0];
+	int trainerID = command->args[1];
+	int level = command->args[2];
+	command->res = CatchPokemon(DS, pokemonID, trainerID, level);
 	return error_free;
 }
 
 /***************************************************************************/
 /* OnFreePokemon                                                            */
 /***************************************************************************/
-static errorType OnFreePokemon(void* DS, const char* const command) {
-	int pokemonID;
-	ValidateRead(sscanf(command, "%d", &pokemonID), 1,
-			"FreePokemon failed.\n");
-	StatusType res = FreePokemon(DS, pokemonID);
-
-	if (res != SUCCESS) {
-		printf("FreePokemon: %s\n", ReturnValToStr(res));
-		return error_free;
-	}
-
-	printf("FreePokemon: %s\n", ReturnValToStr(res));
+static errorType OnFreePokemon(void* DS, Command* command) {
+	int pokemonID = command->args[0];
+	command->res = FreePokemon(DS, pokemonID);
 	return error_free;
 }
 
 /***************************************************************************/
 /* OnLevelUp                                                         */
 /***************************************************************************/
-static errorType OnLevelUp(void* DS, const char* const command) {
-	int pokemonID;
-	int levelIncrease;
-	ValidateRead(sscanf(command, "%d %d", &pokemonID, &levelIncrease), 2,
-			"LevelUp failed.\n");
-	StatusType res = LevelUp(DS, pokemonID, levelIncrease);
-
-	if (res != SUCCESS) {
-		printf("LevelUp: %s\n", ReturnValToStr(res));
-		return error_free;
-	}
-
-	printf("LevelUp: %s\n", ReturnValToStr(res));
+static errorType OnLevelUp(void* DS, Command* command) {
+	int pokemonID = command->args[0];
+	int levelIncrease = command->args[1];
+	command->res = LevelUp(DS, pokemonID, levelIncrease);
 	return error_free;
 }
 
 /***************************************************************************/
 /* OnEvolvePokemon                                                            */
 /***************************************************************************/
-static errorType OnEvolvePokemon(void* DS, const char* const command) {
-	int pokemonID;
-	int evolvedID;
-	ValidateRead(sscanf(command, "%d %d", &pokemonID, &evolvedID), 2,
-			"EvolvePokemon failed.\n");
-	StatusType res = EvolvePokemon(DS, pokemonID, evolvedID);
-
-	if (res != SUCCESS) {
-		printf("EvolvePokemon: %s\n", ReturnValToStr(res));
-		return error_free;
-	}
-
-	printf("EvolvePokemon: %s\n", ReturnValToStr(res));
+static errorType OnEvolvePokemon(void* DS, Command* command) {
+	int pokemonID = command->args[0];
+	int evolvedID = command->args[1];
+	command->res = EvolvePokemon(DS, pokemonID, evolvedID);
 	return error_free;
 }
 
 /***************************************************************************/
 /* OnGetTopPokemon                                                         */
 /***************************************************************************/
-static errorType OnGetTopPokemon(void* DS, const char* const command) {
-	int trainerID;
-	ValidateRead(sscanf(command, "%d", &trainerID), 1, "GetTopPokemon failed.\n");
-	int pokemonID;
-	StatusType res = GetTopPokemon(DS, trainerID, &pokemonID);
-
-	if (res != SUCCESS) {
-		printf("GetTopPokemon: %s\n", ReturnValToStr(res));
-		return error_free;
-	}
-
-	cout << "Pokemon with highest level is: " << pokemonID << endl;
+static errorType OnGetTopPokemon(void* DS, Command* command) {
+	int trainerID = command->args[0];
+	command->res = GetTopPokemon(DS, trainerID, &command->pokemonID);
 	return error_free;
 }
 
@@ -325,67 +1594,58 @@ static errorType OnGetTopPokemon(void* DS, const char* const command) {
 /* OnGetAllGames                                                        */
 /***************************************************************************/
 
-void PrintAll(int *pokemons, int numOfPokemons) {
+static void PrintAll(int *pokemons, int numOfPokemons) {
 	if (numOfPokemons > 0) {
-		cout << "Level	||	Pokemon" << endl;
+		OutPrintf("Level	||	Pokemon\n");
 	}
 
+	// "<level>\t||\t<pokemon>\n", formatted straight into the output buffer
+	const size_t maxRowLength = 2 * FORMAT_INT_MAX_LENGTH + 5;
 	for (int i = 0; i < numOfPokemons; i++) {
-		cout << i + 1 << "\t||\t" << pokemons[i] << endl;
+		char* row = OutReserve(maxRowLength);
+		char* end = row + FormatInt(row, i + 1);
+		memcpy(end, "\t||\t", 4);
+		end += 4;
+		end += FormatInt(end, pokemons[i]);
+		*end++ = '\n';
+		OutCommit(end - row);
 	}
-	cout << "and there are no more pokemons!" << endl;
+	OutPrintf("and there are no more pokemons!\n");
 
 	free (pokemons);
 }
 
-static errorType OnGetAllPokemonsByLevel(void* DS, const char* const command) {
-	int trainerID;
-	ValidateRead(sscanf(command, "%d", &trainerID), 1,
-			"GetAllPokemonsByLevel failed.\n");
-	int* pokemons;
-	int numOfPokemons;
-	StatusType res = GetAllPokemonsByLevel(DS, trainerID, &pokemons, &numOfPokemons);
-
-	if (res != SUCCESS) {
-		printf("GetAllPokemonsByLevel: %s\n", ReturnValToStr(res));
-		return error_free;
-	}
-
-	PrintAll(pokemons, numOfPokemons);
+static errorType OnGetAllPokemonsByLevel(void* DS, Command* command) {
+	int trainerID = command->args[0];
+	command->res = GetAllPokemonsByLevel(DS, trainerID, &command->pokemons,
+			&command->numOfPokemons);
+	if (command->res != SUCCESS)
+		command->pokemons = NULL;
 	return error_free;
 }
 
 /***************************************************************************/
 /* OnUpdateLevels                                                           */
 /***************************************************************************/
-static errorType OnUpdateLevels(void* DS, const char* const command) {
-	int stoneCode;
-	int stoneFactor;
-	ValidateRead(sscanf(command, "%d %d", &stoneCode, &stoneFactor), 2,
-			"UpdateLevels failed.\n");
-	StatusType res = UpdateLevels(DS, stoneCode, stoneFactor);
-
-	if (res != SUCCESS) {
-		printf("UpdateLevels: %s\n", ReturnValToStr(res));
-		return error_free;
-	}
-
-	printf("UpdateLevels: %s\n", ReturnValToStr(res));
+static errorType OnUpdateLevels(void* DS, Command* command) {
+	int stoneCode = command->args[0];
+	int stoneFactor = command->args[1];
+	command->res = UpdateLevels(DS, stoneCode, stoneFactor);
 	return error_free;
 }
 
 /***************************************************************************/
 /* OnQuit                                                                  */
 /***************************************************************************/
-static errorType OnQuit(void** DS, const char* const command) {
+static errorType OnQuit(void** DS, Command* command) {
 	Quit(DS);
 	if (*DS != NULL) {
-		printf("Quit failed.\n");
+		command->res = FAILURE;
 		return error;
 	};
 
 	isInit = false;
-	printf("Quit done.\n");
+	command->res = SUCCESS;
 
 	return error_free;
 }
@@ -0,0 +1,376 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : perfRegress.cpp                                             */
+/*                                                                         */
+/* Performance regression check: runs a benchmark several times and       */
+/* compares its numbers with a committed baseline.                         */
+/*                                                                         */
+/* Usage: perfRegress [-r repetitions] [-t percent] [-k factor] [-u]       */
+/*                    baseline command [arguments]                         */
+/*   -r  The number of times the command runs. Default 5.                  */
+/*   -t  The smallest slowdown that counts, in percent of the baseline.    */
+/*       Default 25, as a ratio carries the noise of both its times.       */
+/*   -k  How many MADs (scaled to standard deviations) a slowdown has to   */
+/*       exceed to count. Default 3.                                       */
+/*   -u  Writes the numbers of this run as the new baseline instead of     */
+/*       comparing.                                                        */
+/*                                                                         */
+/* The command's output is read in either of the benchmark formats of the  */
+/* repo. Its times are turned into ratios within each run, so a baseline  */
+/* taken on one machine holds on another; lower is better:                */
+/*   - avlTreeBench's CSV: "avltree/type/distribution/size/operation/      */
+/*     ratio", AvlTree's time over std::set's for the same row of the run. */
+/*   - main1 -B's table: "<command>.p50/ref" and "<command>.p99/ref" per   */
+/*     command type, and "ns_per_command/ref" for the execution            */
+/*     throughput, in units of a reference std::set workload perfRegress   */
+/*     times before every run.                                             */
+/* Every metric gets the median and the median absolute deviation (MAD)   */
+/* of its values over the runs. A metric regresses when its median grows   */
+/* past the baseline's by more than both thresholds, so a slowdown has to  */
+/* be large and outside the noise of both runs. Only the metrics in the    */
+/* baseline are checked; delete lines from it to stop checking them.       */
+/*                                                                         */
+/* Exits with 1 if any metric regressed, 2 on errors (including baseline   */
+/* metrics the command no longer prints), and 0 otherwise.                 */
+/*                                                                         */
+/* Examples:                                                               */
+/*   perfRegress perfBaseline.txt avlTreeBench -n 10000 -r 3               */
+/*   perfRegress perfBaselineMain1.txt sh -c                               */
+/*       "workloadGen -n 200000 -T 1000 -P 100000 | main1 -B"              */
+/***************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/* The MAD of normally distributed values times this is their standard
+ * deviation */
+#define MAD_TO_SIGMA (1.4826)
+
+/* The number of keys of the reference workload, and how many times it is
+ * timed before every run */
+#define REFERENCE_SIZE        (200000)
+#define REFERENCE_REPETITIONS (3)
+
+typedef std::map<std::string, std::vector<double> > Samples;
+
+/* The numbers of one run, as the benchmark printed them */
+typedef std::map<std::string, double> RunValues;
+
+typedef struct {
+	double median;
+	double mad;
+} Summary;
+
+static double Median(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	size_t middle = values.size() / 2;
+	return values.size() % 2 ? values[middle]
+			: (values[middle - 1] + values[middle]) / 2;
+}
+
+static Summary Summarize(const std::vector<double>& values) {
+	Summary summary;
+	summary.median = Median(values);
+	std::vector<double> deviations;
+	for (size_t i = 0; i < values.size(); i++) {
+		deviations.push_back(fabs(values[i] - summary.median));
+	}
+	summary.mad = Median(deviations);
+	return summary;
+}
+
+/***************************************************************************/
+/* Parsing                                                                 */
+/***************************************************************************/
+
+/* Adds the numbers of one line of benchmark output to values */
+static void ParseLine(const char *line, RunValues& values) {
+	char fields[7][128];
+	double value;
+	// avlTreeBench: container,type,distribution,size,operation,operations,ns
+	if (sscanf(line, "%127[^,],%127[^,],%127[^,],%127[^,],%127[^,],%127[^,],%lf",
+			fields[0], fields[1], fields[2], fields[3], fields[4], fields[5],
+			&value) == 7) {
+		std::string metric = std::string(fields[0]) + "/" + fields[1] + "/"
+				+ fields[2] + "/" + fields[3] + "/" + fields[4];
+		values[metric] = value;
+		return;
+	}
+	// main1 -B: command count p50 p99 p999 max
+	double count, p50, p99, p999, max;
+	if (sscanf(line, "%127s %lf %lf %lf %lf %lf", fields[0], &count, &p50, &p99,
+			&p999, &max) == 6) {
+		values[std::string(fields[0]) + ".p50"] = p50;
+		values[std::string(fields[0]) + ".p99"] = p99;
+		return;
+	}
+	// main1 -B: "... (%f s executing: %f commands/s)"
+	const char *executing = strstr(line, "s executing: ");
+	double commandsPerSecond;
+	if (executing != NULL
+			&& sscanf(executing, "s executing: %lf", &commandsPerSecond) == 1
+			&& commandsPerSecond > 0) {
+		values["ns_per_command"] = 1e9 / commandsPerSecond;
+	}
+}
+
+/***************************************************************************/
+/* Relative metrics                                                        */
+/***************************************************************************/
+
+/* Keeps the optimizer from dropping the reference workload's lookups */
+static volatile long long sink;
+
+/* Times random inserts, lookups and erases on a std::set, in ns per
+ * operation: the median of REFERENCE_REPETITIONS timings. */
+static double ReferenceTime() {
+	std::vector<double> times;
+	for (int repetition = 0; repetition < REFERENCE_REPETITIONS; repetition++) {
+		std::set<unsigned> set;
+		unsigned key = 12345;
+		long long found = 0;
+		std::chrono::steady_clock::time_point start =
+				std::chrono::steady_clock::now();
+		for (int i = 0; i < REFERENCE_SIZE; i++) {
+			key = key * 1103515245 + 12345;
+			set.insert(key >> 4);
+		}
+		for (int i = 0; i < REFERENCE_SIZE; i++) {
+			key = key * 1103515245 + 12345;
+			found += set.count(key >> 4);
+		}
+		while (!set.empty()) {
+			set.erase(set.begin());
+		}
+		std::chrono::duration<double, std::nano> elapsed =
+				std::chrono::steady_clock::now() - start;
+		times.push_back(elapsed.count() / (3.0 * REFERENCE_SIZE));
+		sink = found;
+	}
+	return Median(times);
+}
+
+/* Adds the machine-relative metrics of one run to samples: every avltree row
+ * over its std::set row, and every other time over referenceTime. */
+static void AddRelative(const RunValues& values, double referenceTime,
+		Samples& samples) {
+	const std::string avlTree = "avltree/";
+	const std::string stdSet = "std::set/";
+	for (RunValues::const_iterator entry = values.begin();
+			entry != values.end(); ++entry) {
+		const std::string& metric = entry->first;
+		if (metric.compare(0, avlTree.size(), avlTree) == 0) {
+			RunValues::const_iterator set = values.find(
+					stdSet + metric.substr(avlTree.size()));
+			if (set != values.end() && set->second > 0) {
+				samples[metric + "/ratio"].push_back(entry->second / set->second);
+			}
+		} else if (metric.compare(0, stdSet.size(), stdSet) != 0) {
+			samples[metric + "/ref"].push_back(entry->second / referenceTime);
+		}
+	}
+}
+
+/***************************************************************************/
+/* Running                                                                 */
+/***************************************************************************/
+
+/* Runs a command and reads the numbers of its output into values */
+static bool RunBenchmark(char *const *command, RunValues& values) {
+	int pipeFds[2];
+	if (pipe(pipeFds) != 0) {
+		perror("pipe");
+		return false;
+	}
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return false;
+	}
+	if (pid == 0) {
+		dup2(pipeFds[1], STDOUT_FILENO);
+		close(pipeFds[0]);
+		close(pipeFds[1]);
+		execvp(command[0], command);
+		perror(command[0]);
+		_exit(127);
+	}
+	close(pipeFds[1]);
+	FILE *output = fdopen(pipeFds[0], "r");
+	char *line = NULL;
+	size_t capacity = 0;
+	while (getline(&line, &capacity, output) >= 0) {
+		ParseLine(line, values);
+	}
+	free(line);
+	fclose(output);
+	int status;
+	if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status)
+			|| WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "%s failed\n", command[0]);
+		return false;
+	}
+	return true;
+}
+
+/***************************************************************************/
+/* Baseline                                                                */
+/***************************************************************************/
+
+static bool ReadBaseline(const char *path, std::map<std::string, Summary>& baseline) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		perror(path);
+		return false;
+	}
+	char line[512];
+	char metric[256];
+	Summary summary;
+	while (fgets(line, sizeof(line), file) != NULL) {
+		if (line[0] == '#') {
+			continue;
+		}
+		if (sscanf(line, "%255s %lf %lf", metric, &summary.median, &summary.mad)
+				== 3) {
+			baseline[metric] = summary;
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+/* Writes the baseline with 6 significant digits, so a small ratio and its
+ * MAD keep enough precision for the thresholds computed from them. */
+static bool WriteBaseline(const char *path,
+		const std::map<std::string, Summary>& current, int repetitions,
+		char **command) {
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		perror(path);
+		return false;
+	}
+	fprintf(file, "# perfRegress baseline: metric, median and MAD over %d "
+			"runs (ratios)\n# of:", repetitions);
+	for (char **arg = command; *arg != NULL; arg++) {
+		fprintf(file, strchr(*arg, ' ') != NULL ? " \"%s\"" : " %s", *arg);
+	}
+	fprintf(file, "\n");
+	for (std::map<std::string, Summary>::const_iterator entry = current.begin();
+			entry != current.end(); ++entry) {
+		fprintf(file, "%s %.6g %.6g\n", entry->first.c_str(),
+				entry->second.median, entry->second.mad);
+	}
+	return fclose(file) == 0;
+}
+
+static void Usage(const char *name) {
+	fprintf(stderr, "usage: %s [-r repetitions] [-t percent] [-k factor] [-u] "
+			"baseline command [arguments]\n", name);
+}
+
+int main(int argc, char **argv) {
+	int repetitions = 5;
+	double thresholdPercent = 25;
+	double madFactor = 3;
+	bool update = false;
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		if (strcmp(argv[i], "-u") == 0) {
+			update = true;
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			repetitions = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			thresholdPercent = atof(argv[++i]);
+		} else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+			madFactor = atof(argv[++i]);
+		} else {
+			Usage(argv[0]);
+			return 2;
+		}
+	}
+	if (argc - i < 2 || repetitions < 1 || thresholdPercent < 0
+			|| madFactor < 0) {
+		Usage(argv[0]);
+		return 2;
+	}
+	const char *baselinePath = argv[i];
+	char **command = argv + i + 1;
+
+	Samples samples;
+	for (int run = 0; run < repetitions; run++) {
+		fprintf(stderr, "run %d of %d\n", run + 1, repetitions);
+		double referenceTime = ReferenceTime();
+		RunValues values;
+		if (!RunBenchmark(command, values)) {
+			return 2;
+		}
+		AddRelative(values, referenceTime, samples);
+	}
+	std::map<std::string, Summary> current;
+	for (Samples::const_iterator entry = samples.begin();
+			entry != samples.end(); ++entry) {
+		current[entry->first] = Summarize(entry->second);
+	}
+	if (current.empty()) {
+		fprintf(stderr, "%s printed no benchmark numbers\n", command[0]);
+		return 2;
+	}
+	if (update) {
+		if (!WriteBaseline(baselinePath, current, repetitions, command)) {
+			return 2;
+		}
+		printf("wrote %zu metrics to %s\n", current.size(), baselinePath);
+		return 0;
+	}
+
+	std::map<std::string, Summary> baseline;
+	if (!ReadBaseline(baselinePath, baseline)) {
+		return 2;
+	}
+	int regressions = 0;
+	int missing = 0;
+	printf("%-56s %12s %12s %8s  %s\n", "metric", "baseline", "current",
+			"change", "verdict");
+	for (std::map<std::string, Summary>::const_iterator entry =
+			baseline.begin(); entry != baseline.end(); ++entry) {
+		std::map<std::string, Summary>::const_iterator found = current.find(
+				entry->first);
+		if (found == current.end()) {
+			printf("%-56s %12.4f %12s %8s  missing\n", entry->first.c_str(),
+					entry->second.median, "-", "-");
+			missing++;
+			continue;
+		}
+		const Summary& base = entry->second;
+		const Summary& now = found->second;
+		double slowdown = now.median - base.median;
+		double noise = madFactor * MAD_TO_SIGMA * std::max(base.mad, now.mad);
+		double threshold = std::max(base.median * thresholdPercent / 100,
+				noise);
+		bool regressed = slowdown > threshold;
+		regressions += regressed;
+		printf("%-56s %12.4f %12.4f %+7.1f%%  %s\n", entry->first.c_str(),
+				base.median, now.median,
+				base.median > 0 ? 100 * slowdown / base.median : 0,
+				regressed ? "REGRESSED" : "ok");
+	}
+	printf("%d of %zu metrics regressed", regressions, baseline.size());
+	if (missing > 0) {
+		printf(", %d missing from this run", missing);
+	}
+	printf("\n");
+	if (regressions > 0) {
+		return 1;
+	}
+	return missing > 0 ? 2 : 0;
+}
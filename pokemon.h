@@ -1,15 +1,82 @@
 #ifndef POKEMON_H_
 #define POKEMON_H_
 
+/**
+ * Pokemon - a pokemon of the DS. The DS's ID index orders pokemons by their
+ * ID, so a Pokemon holding only an ID is enough to look one up.
+ */
 class Pokemon {
-	
+	int id;
+	int trainerID;
+	int level;
+
 public:
-	Pokemon();
-	Pokemon(const Pokemon& pokemon);
-	Pokemon();
-	Pokemon& operator=(const Pokemon& pokemon);
-	~Pokemon();
+	explicit Pokemon(int id = 0, int trainerID = 0, int level = 0) :
+			id(id), trainerID(trainerID), level(level) {
+	}
+	Pokemon(const Pokemon& pokemon) = default;
+	Pokemon& operator=(const Pokemon& pokemon) = default;
+	~Pokemon() = default;
+
+	int getID() const {
+		return id;
+	}
+
+	int getTrainerID() const {
+		return trainerID;
+	}
+
+	int getLevel() const {
+		return level;
+	}
+
+	/**
+	 * setLevel - changes the level. the level isn't part of the ID order, so
+	 * this may be called on a pokemon inside the ID index.
+	 */
+	void setLevel(int newLevel) {
+		level = newLevel;
+	}
+
+	/**
+	 * setTrainerID - moves the pokemon to another trainer. like the level,
+	 * the trainer isn't part of the ID order.
+	 */
+	void setTrainerID(int newTrainerID) {
+		trainerID = newTrainerID;
+	}
+
+	bool operator<(const Pokemon& pokemon) const {
+		return id < pokemon.id;
+	}
+};
+
+/**
+ * LevelKey - the place of a pokemon in a level index: higher level first,
+ * pokemons with the same level by ascending ID. This is the order
+ * GetAllPokemonsByLevel returns them in.
+ */
+struct LevelKey {
+	int level;
+	int pokemonID;
+
+	explicit LevelKey(int level = 0, int pokemonID = 0) :
+			level(level), pokemonID(pokemonID) {
+	}
+
+	bool operator<(const LevelKey& key) const {
+		return level != key.level ? level > key.level : pokemonID < key.pokemonID;
+	}
 };
 
+/* Levels wrap around on overflow, computed in unsigned arithmetic so the
+ * overflow is well defined. */
+static inline int AddLevels(int level, int levelIncrease) {
+	return (int) ((unsigned) level + (unsigned) levelIncrease);
+}
+
+static inline int MultiplyLevel(int level, int factor) {
+	return (int) ((unsigned) level * (unsigned) factor);
+}
 
 #endif /* POKEMON_H_ */
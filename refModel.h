@@ -0,0 +1,193 @@
+#ifndef REFMODEL_H_
+#define REFMODEL_H_
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+#include "library1.h"
+
+/**
+ * RefModel - a plain reference implementation of the library1.h semantics
+ * of the shell's commands, on std::map and std::set. It is slow but simple
+ * enough to check by reading, and main1 -V runs it side by side with the DS
+ * to check every result of the real one.
+ *
+ * Where library1.h leaves a case open, the model makes assumptions of its
+ * own: a query for a trainer that isn't in the DS fails with FAILURE, a query
+ * with no pokemons gives -1 as the top pokemon, and levels wrap around on
+ * overflow. They are not taken from library1.h, so a -V mismatch in one of
+ * these cases shows that the DS and the model disagree, not that the DS is
+ * the one that is wrong.
+ */
+class RefModel {
+	// (~level, pokemonID): ~level orders the levels from high to low as
+	// -level would, without overflowing on INT_MIN
+	typedef std::pair<int, int> LevelKey;
+
+	struct Pokemon {
+		int trainerID;
+		int level;
+	};
+
+	std::map<int, std::set<LevelKey> > trainers;
+	std::map<int, Pokemon> pokemons;
+	std::set<LevelKey> allPokemons;
+
+	static int multiply(int level, int factor) {
+		return (int) ((unsigned) level * (unsigned) factor);
+	}
+
+	static int add(int level, int increase) {
+		return (int) ((unsigned) level + (unsigned) increase);
+	}
+
+	void insert(int pokemonID, int trainerID, int level) {
+		Pokemon pokemon = { trainerID, level };
+		pokemons[pokemonID] = pokemon;
+		trainers[trainerID].insert(LevelKey(~level, pokemonID));
+		allPokemons.insert(LevelKey(~level, pokemonID));
+	}
+
+	void erase(std::map<int, Pokemon>::iterator pokemon) {
+		LevelKey key(~pokemon->second.level, pokemon->first);
+		trainers[pokemon->second.trainerID].erase(key);
+		allPokemons.erase(key);
+		pokemons.erase(pokemon);
+	}
+
+	/**
+	 * levelIndex - the level index a query reads.
+	 * @param int trainerID - the trainer, or a negative ID for the whole DS.
+	 * @return - the index, or nullptr if the trainer isn't in the DS.
+	 */
+	const std::set<LevelKey>* levelIndex(int trainerID) const {
+		if (trainerID < 0) {
+			return &allPokemons;
+		}
+		std::map<int, std::set<LevelKey> >::const_iterator trainer =
+				trainers.find(trainerID);
+		return trainer == trainers.end() ? nullptr : &trainer->second;
+	}
+
+public:
+	/**
+	 * clear - empties the model, as Quit followed by Init does.
+	 */
+	void clear() {
+		trainers.clear();
+		pokemons.clear();
+		allPokemons.clear();
+	}
+
+	StatusType addTrainer(int trainerID) {
+		if (trainerID <= 0) {
+			return INVALID_INPUT;
+		}
+		if (trainers.count(trainerID) != 0) {
+			return FAILURE;
+		}
+		trainers[trainerID];
+		return SUCCESS;
+	}
+
+	StatusType catchPokemon(int pokemonID, int trainerID, int level) {
+		if (pokemonID <= 0 || trainerID <= 0 || level <= 0) {
+			return INVALID_INPUT;
+		}
+		if (pokemons.count(pokemonID) != 0 || trainers.count(trainerID) == 0) {
+			return FAILURE;
+		}
+		insert(pokemonID, trainerID, level);
+		return SUCCESS;
+	}
+
+	StatusType freePokemon(int pokemonID) {
+		if (pokemonID <= 0) {
+			return INVALID_INPUT;
+		}
+		std::map<int, Pokemon>::iterator pokemon = pokemons.find(pokemonID);
+		if (pokemon == pokemons.end()) {
+			return FAILURE;
+		}
+		erase(pokemon);
+		return SUCCESS;
+	}
+
+	StatusType levelUp(int pokemonID, int levelIncrease) {
+		if (pokemonID <= 0 || levelIncrease <= 0) {
+			return INVALID_INPUT;
+		}
+		std::map<int, Pokemon>::iterator pokemon = pokemons.find(pokemonID);
+		if (pokemon == pokemons.end()) {
+			return FAILURE;
+		}
+		Pokemon old = pokemon->second;
+		erase(pokemon);
+		insert(pokemonID, old.trainerID, add(old.level, levelIncrease));
+		return SUCCESS;
+	}
+
+	StatusType evolvePokemon(int pokemonID, int evolvedID) {
+		if (pokemonID <= 0 || evolvedID <= 0) {
+			return INVALID_INPUT;
+		}
+		std::map<int, Pokemon>::iterator pokemon = pokemons.find(pokemonID);
+		if (pokemon == pokemons.end() || pokemons.count(evolvedID) != 0) {
+			return FAILURE;
+		}
+		Pokemon old = pokemon->second;
+		erase(pokemon);
+		insert(evolvedID, old.trainerID, old.level);
+		return SUCCESS;
+	}
+
+	StatusType getTopPokemon(int trainerID, int *pokemonID) const {
+		if (trainerID == 0 || pokemonID == nullptr) {
+			return INVALID_INPUT;
+		}
+		const std::set<LevelKey> *index = levelIndex(trainerID);
+		if (index == nullptr) {
+			return FAILURE;
+		}
+		*pokemonID = index->empty() ? -1 : index->begin()->second;
+		return SUCCESS;
+	}
+
+	StatusType getAllPokemonsByLevel(int trainerID,
+			std::vector<int>& pokemonIDs) const {
+		if (trainerID == 0) {
+			return INVALID_INPUT;
+		}
+		const std::set<LevelKey> *index = levelIndex(trainerID);
+		if (index == nullptr) {
+			return FAILURE;
+		}
+		pokemonIDs.clear();
+		for (std::set<LevelKey>::const_iterator key = index->begin();
+				key != index->end(); ++key) {
+			pokemonIDs.push_back(key->second);
+		}
+		return SUCCESS;
+	}
+
+	StatusType updateLevels(int stoneCode, int stoneFactor) {
+		if (stoneCode < 1 || stoneFactor < 1) {
+			return INVALID_INPUT;
+		}
+		std::vector<std::pair<int, Pokemon> > updated;
+		for (std::map<int, Pokemon>::iterator pokemon = pokemons.begin();
+				pokemon != pokemons.end(); ++pokemon) {
+			if (pokemon->first % stoneCode == 0) {
+				updated.push_back(*pokemon);
+			}
+		}
+		for (size_t i = 0; i < updated.size(); i++) {
+			erase(pokemons.find(updated[i].first));
+			insert(updated[i].first, updated[i].second.trainerID,
+					multiply(updated[i].second.level, stoneFactor));
+		}
+		return SUCCESS;
+	}
+};
+
+#endif /* REFMODEL_H_ */
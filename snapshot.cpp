@@ -0,0 +1,257 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : snapshot.cpp                                                */
+/*                                                                         */
+/* Reading and writing of the binary snapshot file described in            */
+/* snapshot.h.                                                             */
+/***************************************************************************/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "snapshot.h"
+
+#define SNAPSHOT_IO_BUFFER_SIZE (1 << 20)
+
+/***************************************************************************/
+/* SnapshotWrite                                                           */
+/***************************************************************************/
+StatusType SnapshotWrite(const char *path, const SnapshotData *data) {
+	if (path == NULL || data == NULL) {
+		return INVALID_INPUT;
+	}
+	SnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.numOfTrainers = data->numOfTrainers;
+	header.numOfPokemons = data->numOfPokemons;
+
+	size_t numOfTrainers = data->numOfTrainers;
+	size_t numOfPokemons = data->numOfPokemons;
+	const void *sections[] = { &header, data->trainers, data->pokemonsByID,
+			data->pokemonsByLevel };
+	size_t sizes[] = { sizeof(header), sizeof(TrainerRecord) * numOfTrainers,
+			sizeof(PokemonRecord) * numOfPokemons, sizeof(PokemonRecord)
+					* numOfPokemons };
+	return SnapshotWriteFile(path, sections, sizes, 4);
+}
+
+/***************************************************************************/
+/* SnapshotWriteFile                                                       */
+/***************************************************************************/
+StatusType SnapshotWriteFile(const char *path, const void * const *sections,
+		const size_t *sizes, int count) {
+	if (path == NULL || sections == NULL || sizes == NULL || count < 0) {
+		return INVALID_INPUT;
+	}
+	size_t pathLength = strlen(path);
+	char *tmpPath = (char*) malloc(pathLength + sizeof(".tmp"));
+	if (tmpPath == NULL) {
+		return ALLOCATION_ERROR;
+	}
+	memcpy(tmpPath, path, pathLength);
+	memcpy(tmpPath + pathLength, ".tmp", sizeof(".tmp"));
+
+	FILE *file = fopen(tmpPath, "wb");
+	if (file == NULL) {
+		free(tmpPath);
+		return FAILURE;
+	}
+	setvbuf(file, NULL, _IOFBF, SNAPSHOT_IO_BUFFER_SIZE);
+
+	bool ok = true;
+	for (int i = 0; i < count && ok; i++) {
+		ok = sizes[i] == 0 || fwrite(sections[i], sizes[i], 1, file) == 1;
+	}
+	ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+	ok = (fclose(file) == 0) && ok;
+	ok = ok && rename(tmpPath, path) == 0;
+	if (!ok) {
+		remove(tmpPath);
+	}
+	free(tmpPath);
+	// the rename itself is durable only once the directory is synced
+	if (ok) {
+		return SnapshotSyncDirectory(path);
+	}
+	return FAILURE;
+}
+
+/***************************************************************************/
+/* SnapshotSyncDirectory                                                   */
+/***************************************************************************/
+StatusType SnapshotSyncDirectory(const char *path) {
+	if (path == NULL) {
+		return INVALID_INPUT;
+	}
+	const char *slash = strrchr(path, '/');
+	size_t length = (slash == NULL) ? 1 : (slash == path) ? 1 : slash - path;
+	char *directory = (char*) malloc(length + 1);
+	if (directory == NULL) {
+		return ALLOCATION_ERROR;
+	}
+	memcpy(directory, (slash == NULL) ? "." : path, length);
+	directory[length] = '\0';
+
+	int fd = open(directory, O_RDONLY | O_DIRECTORY);
+	free(directory);
+	if (fd < 0) {
+		return FAILURE;
+	}
+	bool ok = fsync(fd) == 0;
+	ok = (close(fd) == 0) && ok;
+	return ok ? SUCCESS : FAILURE;
+}
+
+/***************************************************************************/
+/* SnapshotValidate                                                        */
+/***************************************************************************/
+
+/* Whether pokemon a comes before pokemon b in the level order: higher level
+ * first, pokemons with the same level by ascending ID. */
+static bool LevelOrderBefore(const PokemonRecord *a, const PokemonRecord *b) {
+	return a->level != b->level ? a->level > b->level
+			: a->pokemonID < b->pokemonID;
+}
+
+/* The record of pokemonID in the pokemonsByID section, or NULL. */
+static const PokemonRecord* FindPokemonRecord(const SnapshotData *data,
+		int32_t pokemonID) {
+	int low = 0;
+	int high = data->numOfPokemons - 1;
+	while (low <= high) {
+		int middle = low + (high - low) / 2;
+		const PokemonRecord *record = &data->pokemonsByID[middle];
+		if (record->pokemonID == pokemonID) {
+			return record;
+		}
+		if (record->pokemonID < pokemonID) {
+			low = middle + 1;
+		} else {
+			high = middle - 1;
+		}
+	}
+	return NULL;
+}
+
+static bool TrainerExists(const SnapshotData *data, int32_t trainerID) {
+	int low = 0;
+	int high = data->numOfTrainers - 1;
+	while (low <= high) {
+		int middle = low + (high - low) / 2;
+		int32_t id = data->trainers[middle].trainerID;
+		if (id == trainerID) {
+			return true;
+		}
+		if (id < trainerID) {
+			low = middle + 1;
+		} else {
+			high = middle - 1;
+		}
+	}
+	return false;
+}
+
+StatusType SnapshotValidate(const SnapshotData *data) {
+	if (data == NULL) {
+		return INVALID_INPUT;
+	}
+	for (int i = 0; i < data->numOfTrainers; i++) {
+		if (data->trainers[i].trainerID <= 0 || (i > 0
+				&& data->trainers[i].trainerID
+						<= data->trainers[i - 1].trainerID)) {
+			return FAILURE;
+		}
+	}
+	for (int i = 0; i < data->numOfPokemons; i++) {
+		const PokemonRecord *record = &data->pokemonsByID[i];
+		if (record->pokemonID <= 0 || (i > 0
+				&& record->pokemonID <= data->pokemonsByID[i - 1].pokemonID)
+				|| !TrainerExists(data, record->trainerID)) {
+			return FAILURE;
+		}
+	}
+	// strictly in level order, so no pokemon appears twice; with every record
+	// matching one of pokemonsByID, the two sections hold the same pokemons
+	for (int i = 0; i < data->numOfPokemons; i++) {
+		const PokemonRecord *record = &data->pokemonsByLevel[i];
+		const PokemonRecord *byID = FindPokemonRecord(data, record->pokemonID);
+		if ((i > 0 && !LevelOrderBefore(&data->pokemonsByLevel[i - 1], record))
+				|| byID == NULL || byID->trainerID != record->trainerID
+				|| byID->level != record->level) {
+			return FAILURE;
+		}
+	}
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* SnapshotRead                                                            */
+/***************************************************************************/
+StatusType SnapshotRead(const char *path, SnapshotData *data) {
+	if (path == NULL || data == NULL) {
+		return INVALID_INPUT;
+	}
+	memset(data, 0, sizeof(*data));
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return FAILURE;
+	}
+	setvbuf(file, NULL, _IOFBF, SNAPSHOT_IO_BUFFER_SIZE);
+
+	SnapshotHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1
+			|| memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+			|| header.version != SNAPSHOT_VERSION || header.numOfTrainers < 0
+			|| header.numOfPokemons < 0) {
+		fclose(file);
+		return FAILURE;
+	}
+
+	size_t numOfTrainers = header.numOfTrainers;
+	size_t numOfPokemons = header.numOfPokemons;
+	data->numOfTrainers = header.numOfTrainers;
+	data->numOfPokemons = header.numOfPokemons;
+	// malloc(0) may return NULL, so always ask for at least one record
+	data->trainers = (TrainerRecord*) malloc(
+			sizeof(TrainerRecord) * (numOfTrainers + 1));
+	data->pokemonsByID = (PokemonRecord*) malloc(
+			sizeof(PokemonRecord) * (numOfPokemons + 1));
+	data->pokemonsByLevel = (PokemonRecord*) malloc(
+			sizeof(PokemonRecord) * (numOfPokemons + 1));
+	if (data->trainers == NULL || data->pokemonsByID == NULL
+			|| data->pokemonsByLevel == NULL) {
+		fclose(file);
+		SnapshotFree(data);
+		return ALLOCATION_ERROR;
+	}
+
+	bool ok = fread(data->trainers, sizeof(TrainerRecord), numOfTrainers,
+			file) == numOfTrainers
+			&& fread(data->pokemonsByID, sizeof(PokemonRecord), numOfPokemons,
+					file) == numOfPokemons
+			&& fread(data->pokemonsByLevel, sizeof(PokemonRecord),
+					numOfPokemons, file) == numOfPokemons;
+	fclose(file);
+	if (!ok || SnapshotValidate(data) != SUCCESS) {
+		SnapshotFree(data);
+		return FAILURE;
+	}
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* SnapshotFree                                                            */
+/***************************************************************************/
+void SnapshotFree(SnapshotData *data) {
+	if (data == NULL) {
+		return;
+	}
+	free(data->trainers);
+	free(data->pokemonsByID);
+	free(data->pokemonsByLevel);
+	memset(data, 0, sizeof(*data));
+}
@@ -0,0 +1,125 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+#include <stddef.h>
+#include <stdint.h>
+#include "library1.h"
+
+/*
+ * Binary snapshot of the whole DS, written by SaveSnapshot and read back by
+ * LoadSnapshot (see library1.h).
+ *
+ * The file is a SnapshotHeader followed by three sections of fixed-width
+ * records, each already in the order one of the DS indexes needs, so every
+ * index is rebuilt in O(n) with AvlTree::buildFromSorted instead of n inserts:
+ *   1. numOfTrainers TrainerRecords, sorted by trainerID.
+ *   2. numOfPokemons PokemonRecords, sorted by pokemonID.
+ *   3. numOfPokemons PokemonRecords, in the order GetAllPokemonsByLevel
+ *      returns them. a trainer's pokemons appear in this section in the
+ *      order of that trainer's own level index.
+ * Integers are stored in the byte order of the machine that wrote the file.
+ */
+
+#define SNAPSHOT_MAGIC   "PKMNSNAP"
+#define SNAPSHOT_VERSION (1)
+
+typedef struct {
+	char magic[8];
+	int32_t version;
+	int32_t numOfTrainers;
+	int32_t numOfPokemons;
+	int32_t reserved;
+} SnapshotHeader;
+
+typedef struct {
+	int32_t trainerID;
+} TrainerRecord;
+
+typedef struct {
+	int32_t pokemonID;
+	int32_t trainerID;
+	int32_t level;
+} PokemonRecord;
+
+/* The sections of a snapshot, as read from the file. */
+typedef struct {
+	int numOfTrainers;
+	int numOfPokemons;
+	TrainerRecord *trainers;
+	PokemonRecord *pokemonsByID;
+	PokemonRecord *pokemonsByLevel;
+} SnapshotData;
+
+/* Description:   Writes a snapshot file. The file is written next to path and
+ *                renamed over it only once complete, so a crash never leaves a
+ *                partial snapshot behind. The file and then its directory are
+ *                synced, so the rename survives a crash too.
+ * Input:         path - The file to write.
+ *                data - The sections to write, already sorted as described above.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If any of the arguments is NULL.
+ *                FAILURE - If writing the file failed.
+ *                SUCCESS - Otherwise.
+ */
+StatusType SnapshotWrite(const char *path, const SnapshotData *data);
+
+/* Description:   Writes count consecutive sections to a file, through the same
+ *                write-to-temporary-file-and-rename path as SnapshotWrite. Used
+ *                by other snapshot formats built on the records above.
+ * Input:         path - The file to write.
+ *                sections - The sections to write, in order.
+ *                sizes - The size in bytes of each section.
+ *                count - The number of sections.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If any of the arguments is NULL or if count < 0.
+ *                FAILURE - If writing the file failed.
+ *                SUCCESS - Otherwise.
+ */
+StatusType SnapshotWriteFile(const char *path, const void * const *sections,
+		const size_t *sizes, int count);
+
+/* Description:   Writes to disk the directory entries of the directory that
+ *                holds path, such as a file just created or renamed into it.
+ * Input:         path - A path inside the directory.
+ * Output:        None.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If path==NULL.
+ *                FAILURE - If the directory can't be opened or synced.
+ *                SUCCESS - Otherwise.
+ */
+StatusType SnapshotSyncDirectory(const char *path);
+
+/* Description:   Checks that sections are sorted as described above, without
+ *                duplicate IDs, that the two pokemon sections hold the same
+ *                pokemons, and that every pokemon's trainer is in the
+ *                sections, in O(n log n). Every index is built from the
+ *                sections as they are, so they must pass this check first.
+ * Input:         data - The sections to check.
+ * Output:        None.
+ * Return Values: INVALID_INPUT - If data==NULL.
+ *                FAILURE - If the sections aren't valid.
+ *                SUCCESS - Otherwise.
+ */
+StatusType SnapshotValidate(const SnapshotData *data);
+
+/* Description:   Reads a snapshot file written by SnapshotWrite, and checks
+ *                its sections with SnapshotValidate.
+ * Input:         path - The file to read.
+ * Output:        data - Updated with the sections of the file. The arrays are
+ *                allocated with malloc and released by SnapshotFree.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error.
+ *                INVALID_INPUT - If any of the arguments is NULL.
+ *                FAILURE - If the file can't be read or isn't a valid snapshot.
+ *                SUCCESS - Otherwise.
+ */
+StatusType SnapshotRead(const char *path, SnapshotData *data);
+
+/* Description:   Releases the arrays allocated by SnapshotRead.
+ * Input:         data - The sections to release.
+ * Output:        None.
+ * Return Values: None.
+ */
+void SnapshotFree(SnapshotData *data);
+
+#endif /* SNAPSHOT_H_ */
@@ -0,0 +1,324 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : snapshotTest.cpp                                            */
+/*                                                                         */
+/* Tests of the binary snapshot described in snapshot.h: a DS saved with  */
+/* SaveSnapshot loads back into an equal DS, and SnapshotRead and         */
+/* LoadSnapshot reject truncated files, a bad header and sections that    */
+/* SnapshotValidate doesn't accept.                                        */
+/*                                                                         */
+/* Usage: snapshotTest                                                     */
+/*                                                                         */
+/* Built from snapshotTest.cpp and library1.cpp with its dependencies.    */
+/* Prints every failed check and exits with 1 if any failed, 0 otherwise. */
+/***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "snapshot.h"
+#include "library1.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+					#condition); \
+			failures++; \
+		} \
+	} while (0)
+
+static const char *path = "snapshotTest.snapshot";
+
+/* The trainers of the test DS; 4 has no pokemons. */
+static const int trainerIDs[] = { 1, 2, 4 };
+static const int numOfTrainerIDs = 3;
+
+/* A DS with every trainer of trainerIDs, levels with ties and a mutation of
+ * every kind behind it. */
+static void* MakeDS() {
+	void *DS = Init();
+	if (DS == NULL) {
+		return NULL;
+	}
+	for (int i = 0; i < numOfTrainerIDs; i++) {
+		CHECK(AddTrainer(DS, trainerIDs[i]) == SUCCESS);
+	}
+	CHECK(CatchPokemon(DS, 10, 1, 5) == SUCCESS);
+	CHECK(CatchPokemon(DS, 11, 1, 5) == SUCCESS);
+	CHECK(CatchPokemon(DS, 12, 1, 9) == SUCCESS);
+	CHECK(CatchPokemon(DS, 20, 2, 7) == SUCCESS);
+	CHECK(CatchPokemon(DS, 21, 2, 1) == SUCCESS);
+	CHECK(CatchPokemon(DS, 22, 2, 3) == SUCCESS);
+	CHECK(LevelUp(DS, 21, 4) == SUCCESS);
+	CHECK(EvolvePokemon(DS, 22, 30) == SUCCESS);
+	CHECK(FreePokemon(DS, 11) == SUCCESS);
+	CHECK(UpdateLevels(DS, 10, 2) == SUCCESS);
+	return DS;
+}
+
+/* Checks that two DSs hold the same pokemons of trainerID in the same order,
+ * with the same statistics. */
+static void CheckSameDS(void *DS, void *other, int trainerID) {
+	int *pokemons = NULL;
+	int numOfPokemons = -1;
+	int *otherPokemons = NULL;
+	int numOfOther = -2;
+	CHECK(GetAllPokemonsByLevel(DS, trainerID, &pokemons, &numOfPokemons)
+			== SUCCESS);
+	CHECK(GetAllPokemonsByLevel(other, trainerID, &otherPokemons, &numOfOther)
+			== SUCCESS);
+	CHECK(numOfOther == numOfPokemons);
+	for (int i = 0; i < numOfPokemons && i < numOfOther; i++) {
+		CHECK(otherPokemons[i] == pokemons[i]);
+	}
+	int count = 0, otherCount = -1;
+	long long sum = 0, otherSum = -1;
+	int max = 0, otherMax = -1;
+	CHECK(GetTrainerStats(DS, trainerID, &count, &sum, &max) == SUCCESS);
+	CHECK(GetTrainerStats(other, trainerID, &otherCount, &otherSum, &otherMax)
+			== SUCCESS);
+	CHECK(count == otherCount && sum == otherSum && max == otherMax);
+	free(pokemons);
+	free(otherPokemons);
+}
+
+/* Reads the whole file at path. NULL if it can't be read. */
+static char* ReadFile(size_t *size) {
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+	fseek(file, 0, SEEK_END);
+	*size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char *bytes = (char*) malloc(*size);
+	if (bytes != NULL && fread(bytes, 1, *size, file) != *size) {
+		free(bytes);
+		bytes = NULL;
+	}
+	fclose(file);
+	return bytes;
+}
+
+static void WriteFile(const char *bytes, size_t size) {
+	FILE *file = fopen(path, "wb");
+	CHECK(file != NULL);
+	if (file != NULL) {
+		CHECK(fwrite(bytes, 1, size, file) == size);
+		fclose(file);
+	}
+}
+
+/* Checks that both SnapshotRead and LoadSnapshot reject the file at path,
+ * and that SnapshotRead leaves nothing allocated behind. */
+static void CheckRejected() {
+	SnapshotData data;
+	CHECK(SnapshotRead(path, &data) == FAILURE);
+	CHECK(data.trainers == NULL && data.pokemonsByID == NULL
+			&& data.pokemonsByLevel == NULL);
+	void *DS = LoadSnapshot(path);
+	CHECK(DS == NULL);
+	Quit(&DS);
+}
+
+static void TestInvalid() {
+	void *DS = Init();
+	SnapshotData data;
+	CHECK(SaveSnapshot(NULL, path) == INVALID_INPUT);
+	CHECK(SaveSnapshot(DS, NULL) == INVALID_INPUT);
+	CHECK(SnapshotRead(NULL, &data) == INVALID_INPUT);
+	CHECK(SnapshotRead(path, NULL) == INVALID_INPUT);
+	CHECK(SnapshotValidate(NULL) == INVALID_INPUT);
+	CHECK(LoadSnapshot(NULL) == NULL);
+	unlink(path);
+	CHECK(SnapshotRead(path, &data) == FAILURE);
+	CHECK(LoadSnapshot(path) == NULL);
+	Quit(&DS);
+}
+
+/* DS -> SaveSnapshot -> SnapshotRead and LoadSnapshot. */
+static void TestRoundTrip() {
+	void *DS = MakeDS();
+	CHECK(DS != NULL);
+	if (DS == NULL) {
+		return;
+	}
+	CHECK(SaveSnapshot(DS, path) == SUCCESS);
+	SnapshotData data;
+	CHECK(SnapshotRead(path, &data) == SUCCESS);
+	CHECK(data.numOfTrainers == numOfTrainerIDs);
+	CHECK(data.numOfPokemons == 5);
+	if (data.numOfPokemons == 5) {
+		CHECK(data.pokemonsByID[0].pokemonID == 10);
+		CHECK(data.pokemonsByID[4].pokemonID == 30);
+		CHECK(data.pokemonsByLevel[0].pokemonID == 20);
+		CHECK(data.pokemonsByLevel[0].level == 14);
+	}
+	SnapshotFree(&data);
+
+	void *loaded = LoadSnapshot(path);
+	CHECK(loaded != NULL);
+	if (loaded != NULL) {
+		CheckSameDS(DS, loaded, -1);
+		for (int i = 0; i < numOfTrainerIDs; i++) {
+			CheckSameDS(DS, loaded, trainerIDs[i]);
+		}
+		// the loaded DS is a regular, mutable one
+		CHECK(CatchPokemon(loaded, 40, 4, 100) == SUCCESS);
+		int top = 0;
+		CHECK(GetTopPokemon(loaded, -1, &top) == SUCCESS);
+		CHECK(top == 40);
+		Quit(&loaded);
+	}
+
+	// an empty DS round trips too
+	void *empty = Init();
+	CHECK(SaveSnapshot(empty, path) == SUCCESS);
+	void *loadedEmpty = LoadSnapshot(path);
+	CHECK(loadedEmpty != NULL);
+	if (loadedEmpty != NULL) {
+		int top = 0;
+		CHECK(GetTopPokemon(loadedEmpty, -1, &top) == SUCCESS);
+		CHECK(top == -1);
+		Quit(&loadedEmpty);
+	}
+	Quit(&empty);
+	Quit(&DS);
+	unlink(path);
+}
+
+/* Truncated files and a bad header are rejected as a whole. */
+static void TestCorrupted() {
+	void *DS = MakeDS();
+	CHECK(DS != NULL && SaveSnapshot(DS, path) == SUCCESS);
+	Quit(&DS);
+	size_t size = 0;
+	char *saved = ReadFile(&size);
+	CHECK(saved != NULL);
+	if (saved == NULL) {
+		return;
+	}
+
+	WriteFile(saved, 0);
+	CheckRejected();
+	WriteFile(saved, sizeof(SnapshotHeader) - 1);
+	CheckRejected();
+	WriteFile(saved, sizeof(SnapshotHeader));
+	CheckRejected();
+	// torn in the middle of the last record
+	WriteFile(saved, size - 1);
+	CheckRejected();
+	WriteFile(saved, size - sizeof(PokemonRecord));
+	CheckRejected();
+
+	char *bytes = (char*) malloc(size);
+	memcpy(bytes, saved, size);
+	bytes[0] = 'X';
+	WriteFile(bytes, size);
+	CheckRejected();
+	memcpy(bytes, saved, size);
+	((SnapshotHeader*) bytes)->version = SNAPSHOT_VERSION + 1;
+	WriteFile(bytes, size);
+	CheckRejected();
+	memcpy(bytes, saved, size);
+	((SnapshotHeader*) bytes)->numOfPokemons = -1;
+	WriteFile(bytes, size);
+	CheckRejected();
+	memcpy(bytes, saved, size);
+	((SnapshotHeader*) bytes)->numOfPokemons++;
+	WriteFile(bytes, size);
+	CheckRejected();
+
+	// a well-formed file whose sections aren't sorted
+	memcpy(bytes, saved, size);
+	PokemonRecord *pokemonsByID = (PokemonRecord*) (bytes
+			+ sizeof(SnapshotHeader) + sizeof(TrainerRecord) * numOfTrainerIDs);
+	PokemonRecord first = pokemonsByID[0];
+	pokemonsByID[0] = pokemonsByID[1];
+	pokemonsByID[1] = first;
+	WriteFile(bytes, size);
+	CheckRejected();
+
+	WriteFile(saved, size);
+	SnapshotData data;
+	CHECK(SnapshotRead(path, &data) == SUCCESS);
+	SnapshotFree(&data);
+
+	free(bytes);
+	free(saved);
+	unlink(path);
+}
+
+/* SnapshotValidate on sections changed one way at a time. */
+static void TestValidate() {
+	TrainerRecord trainers[] = { { 1 }, { 2 } };
+	PokemonRecord byID[] = { { 10, 1, 5 }, { 11, 2, 5 }, { 12, 1, 9 } };
+	PokemonRecord byLevel[] = { { 12, 1, 9 }, { 10, 1, 5 }, { 11, 2, 5 } };
+	SnapshotData data;
+	data.numOfTrainers = 2;
+	data.numOfPokemons = 3;
+	data.trainers = trainers;
+	data.pokemonsByID = byID;
+	data.pokemonsByLevel = byLevel;
+	CHECK(SnapshotValidate(&data) == SUCCESS);
+
+	// trainers unsorted, then duplicated
+	trainers[0].trainerID = 3;
+	CHECK(SnapshotValidate(&data) == FAILURE);
+	trainers[0].trainerID = 2;
+	CHECK(SnapshotValidate(&data) == FAILURE);
+	trainers[0].trainerID = 1;
+
+	// a duplicate pokemon ID
+	byID[1].pokemonID = 10;
+	CHECK(SnapshotValidate(&data) == FAILURE);
+	byID[1].pokemonID = 11;
+
+	// a pokemon of a missing trainer
+	byID[1].trainerID = 3;
+	byLevel[2].trainerID = 3;
+	CHECK(SnapshotValidate(&data) == FAILURE);
+	byID[1].trainerID = 2;
+	byLevel[2].trainerID = 2;
+
+	// the level section out of level order, then by ID on a tie
+	PokemonRecord top = byLevel[0];
+	byLevel[0] = byLevel[1];
+	byLevel[1] = top;
+	CHECK(SnapshotValidate(&data) == FAILURE);
+	byLevel[1] = byLevel[0];
+	byLevel[0] = top;
+	PokemonRecord tie = byLevel[1];
+	byLevel[1] = byLevel[2];
+	byLevel[2] = tie;
+	CHECK(SnapshotValidate(&data) == FAILURE);
+	byLevel[2] = byLevel[1];
+	byLevel[1] = tie;
+
+	// the level section disagreeing with the ID section
+	byLevel[2].level = 4;
+	CHECK(SnapshotValidate(&data) == FAILURE);
+	byLevel[2].level = 5;
+	byLevel[2].trainerID = 1;
+	CHECK(SnapshotValidate(&data) == FAILURE);
+	byLevel[2].trainerID = 2;
+
+	CHECK(SnapshotValidate(&data) == SUCCESS);
+}
+
+int main() {
+	TestInvalid();
+	TestRoundTrip();
+	TestCorrupted();
+	TestValidate();
+	if (failures > 0) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	printf("snapshotTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,166 @@
+#ifndef SPSCRING_H_
+#define SPSCRING_H_
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <sched.h>
+#include <time.h>
+
+/**
+ * SpscRing - a bounded queue of T objects between exactly one producer thread
+ * and exactly one consumer thread, without locks.
+ *
+ * The producer only writes tail and the consumer only writes head, each with
+ * release ordering after it copied an element in or out, so the other side
+ * sees the element once it sees the index move. Each side also keeps its own
+ * copy of the other side's index and reloads it only when the ring looks full
+ * (or empty), so a steady stream of elements doesn't bounce the index cache
+ * lines between the two cores on every element.
+ */
+template<class T>
+class SpscRing {
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	T *elements;
+	size_t mask;
+
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;
+	size_t cachedTail;
+
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;
+	size_t cachedHead;
+
+	/**
+	 * wait - backs off while the other side catches up: spins first, then
+	 * yields the core, then sleeps, so an idle ring (a shell waiting for
+	 * input) doesn't keep a core busy.
+	 *
+	 * @param int& spins - the number of times the caller waited so far.
+	 */
+	static void wait(int& spins) {
+		spins++;
+		if (spins > 1024) {
+			struct timespec pause = { 0, 50000 };
+			nanosleep(&pause, nullptr);
+		} else if (spins > 64) {
+			sched_yield();
+		}
+	}
+
+public:
+	/**
+	 * SpscRing c'tor - constructs an empty ring.
+	 *
+	 * @param size_t capacity - the least number of elements the ring holds.
+	 * 				rounded up to a power of two.
+	 *
+	 * @throw - std::bad_alloc - in case of an allocation error
+	 *
+	 * @return new SpscRing
+	 */
+	explicit SpscRing(size_t capacity);
+
+	~SpscRing();
+
+	SpscRing(const SpscRing<T>&) = delete;
+	SpscRing<T>& operator=(const SpscRing<T>&) = delete;
+
+	/**
+	 * tryPush - adds a copy of an element at the ring's tail.
+	 * may only be called by the producer thread.
+	 *
+	 * @param const T& element - the element to add.
+	 *
+	 * @return - true if the element was added, false if the ring is full.
+	 */
+	bool tryPush(const T& element);
+
+	/**
+	 * push - adds a copy of an element at the ring's tail, waiting while the
+	 * ring is full. may only be called by the producer thread.
+	 *
+	 * @param const T& element - the element to add.
+	 */
+	void push(const T& element);
+
+	/**
+	 * tryPop - takes the element at the ring's head.
+	 * may only be called by the consumer thread.
+	 *
+	 * @param T& element - updated with the element taken.
+	 *
+	 * @return - true if an element was taken, false if the ring is empty.
+	 */
+	bool tryPop(T& element);
+
+	/**
+	 * pop - takes the element at the ring's head, waiting while the ring is
+	 * empty. may only be called by the consumer thread.
+	 *
+	 * @param T& element - updated with the element taken.
+	 */
+	void pop(T& element);
+};
+
+template<class T>
+SpscRing<T>::SpscRing(size_t capacity) :
+		elements(nullptr), mask(0), head(0), cachedTail(0), tail(0),
+		cachedHead(0) {
+	size_t size = 1;
+	while (size < capacity) {
+		size <<= 1;
+	}
+	elements = new T[size];
+	mask = size - 1;
+}
+
+template<class T>
+SpscRing<T>::~SpscRing() {
+	delete[] elements;
+}
+
+template<class T>
+bool SpscRing<T>::tryPush(const T& element) {
+	size_t position = tail.load(std::memory_order_relaxed);
+	if (position - cachedHead > mask) {
+		cachedHead = head.load(std::memory_order_acquire);
+		if (position - cachedHead > mask) {
+			return false;
+		}
+	}
+	elements[position & mask] = element;
+	tail.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+template<class T>
+void SpscRing<T>::push(const T& element) {
+	int spins = 0;
+	while (!tryPush(element)) {
+		wait(spins);
+	}
+}
+
+template<class T>
+bool SpscRing<T>::tryPop(T& element) {
+	size_t position = head.load(std::memory_order_relaxed);
+	if (position == cachedTail) {
+		cachedTail = tail.load(std::memory_order_acquire);
+		if (position == cachedTail) {
+			return false;
+		}
+	}
+	element = elements[position & mask];
+	head.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+template<class T>
+void SpscRing<T>::pop(T& element) {
+	int spins = 0;
+	while (!tryPop(element)) {
+		wait(spins);
+	}
+}
+
+#endif /* SPSCRING_H_ */
@@ -0,0 +1,141 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : textToBinary.cpp                                            */
+/*                                                                         */
+/* Converts a text command trace of the main1 shell into the binary        */
+/* command stream described in binaryProtocol.h, for main1 -b.             */
+/*                                                                         */
+/* Usage: textToBinary [text trace [binary stream]]                        */
+/* Reads stdin and writes stdout when the files aren't given.              */
+/*                                                                         */
+/* Lines are matched to commands the way the shell does. The shell stops   */
+/* at an empty line, an unknown command or a command with malformed        */
+/* arguments, so the conversion stops there too and says so on stderr. A  */
+/* command with malformed arguments still prints its failure, so it is    */
+/* written with the arguments that did parse as the last record, which    */
+/* main1 -b reports the same way.                                          */
+/***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tokenizer.h"
+#include "binaryProtocol.h"
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+/* The shell's command names, indexed by opcode */
+static const char *commandStr[] = { NULL, "Init", "AddTrainer", "CatchPokemon",
+		"FreePokemon", "LevelUp", "EvolvePokemon", "GetTopPokemon",
+		"GetAllPokemonsByLevel", "UpdateLevels", "Quit" };
+
+static bool WriteRecord(FILE *output, int op, const int32_t *args,
+		int numOfArgs) {
+	unsigned char opcode = (unsigned char) op;
+	return fwrite(&opcode, 1, 1, output) == 1
+			&& (numOfArgs == 0
+					|| fwrite(args, sizeof(int32_t), numOfArgs, output)
+							== (size_t) numOfArgs);
+}
+
+/* Description:   Converts one line of a text trace.
+ * Input:         line - The line, with its '\n' if it has one.
+ *                length - The length of the line.
+ *                output - The binary stream.
+ * Output:        malformed - Set to whether the line is a command with
+ *                malformed arguments. Its record, written with the arguments
+ *                that did parse, must be the last one of the stream.
+ * Return Values: The opcode written, 0 if the shell would stop at this line
+ *                without running it, or -1 if writing failed.
+ */
+static int ConvertLine(const char *line, size_t length, FILE *output,
+		bool *malformed) {
+	*malformed = false;
+	if (length == 0 || line[0] == '\n') {
+		return 0;
+	}
+	if (line[0] == '#') {
+		if (length == 1) {
+			return BINARY_COMMENT; // the shell echoes nothing
+		}
+		int32_t textLength = (int32_t) length;
+		if (!WriteRecord(output, BINARY_COMMENT, &textLength, 1)
+				|| fwrite(line, 1, length, output) != length) {
+			return -1;
+		}
+		return BINARY_COMMENT;
+	}
+	for (int op = BINARY_INIT; op <= BINARY_QUIT; op++) {
+		size_t nameLength = strlen(commandStr[op]);
+		if (strncmp(commandStr[op], line, nameLength) != 0) {
+			continue;
+		}
+		// skip the separator after the name, but never the end of the line
+		const char *argsStr = line + nameLength;
+		if (*argsStr != '\0' && *argsStr != '\n') {
+			argsStr++;
+		}
+		int args[BINARY_MAX_ARGS];
+		int numOfArgs = BinaryOpArgs(op);
+		int numOfParsed = ReadInts(argsStr, args, numOfArgs);
+		if (numOfParsed != numOfArgs) {
+			*malformed = true;
+			numOfArgs = numOfParsed;
+		}
+		int32_t values[BINARY_MAX_ARGS];
+		for (int i = 0; i < numOfArgs; i++) {
+			values[i] = args[i];
+		}
+		return WriteRecord(output, op, values, numOfArgs) ? op : -1;
+	}
+	return 0;
+}
+
+int main(int argc, const char**argv) {
+	if (argc > 3) {
+		fprintf(stderr, "usage: %s [text trace [binary stream]]\n", argv[0]);
+		return 1;
+	}
+	FILE *input = (argc > 1) ? fopen(argv[1], "r") : stdin;
+	if (input == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	FILE *output = (argc > 2) ? fopen(argv[2], "wb") : stdout;
+	if (output == NULL) {
+		perror(argv[2]);
+		return 1;
+	}
+	setvbuf(output, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+	bool ok = fwrite(BINARY_MAGIC, BINARY_MAGIC_SIZE, 1, output) == 1;
+	char *line = NULL;
+	size_t capacity = 0;
+	ssize_t length;
+	long lineNumber = 0;
+	while (ok && (length = getline(&line, &capacity, input)) >= 0) {
+		lineNumber++;
+		bool malformed;
+		int op = ConvertLine(line, length, output, &malformed);
+		if (op < 0) {
+			ok = false;
+		} else if (op == 0 || malformed) {
+			fprintf(stderr, "line %ld: the shell stops here, "
+					"the rest of the trace isn't converted\n", lineNumber);
+			break;
+		}
+	}
+	free(line);
+	if (ferror(input)) {
+		ok = false;
+	}
+	ok = (fflush(output) == 0) && ok;
+	if (output != stdout) {
+		ok = (fclose(output) == 0) && ok;
+	}
+	if (!ok) {
+		fprintf(stderr, "conversion failed\n");
+		return 1;
+	}
+	return 0;
+}
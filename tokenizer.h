@@ -0,0 +1,61 @@
+#ifndef TOKENIZER_H_
+#define TOKENIZER_H_
+#include <limits.h>
+
+/*
+ * Fast integer tokenizer for the shell's command arguments, replacing
+ * sscanf(command, "%d %d ...") without its locale and format-string overhead.
+ */
+
+static inline bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* Description:   Reads up to count integers from str, the way
+ *                sscanf(str, "%d %d ...") does: each integer may follow
+ *                whitespace and starts with an optional sign followed by at
+ *                least one digit. Reading stops at the first integer that
+ *                can't be read. Values that don't fit an int are converted
+ *                as glibc's sscanf converts them: saturated to a long, like
+ *                strtol, and then truncated to an int, so
+ *                "99999999999999999999" reads as -1.
+ *                Unlike sscanf, a newline ends the input, so str doesn't have
+ *                to be NUL-terminated after its line.
+ * Input:         str - The string to read.
+ *                count - The number of integers to read.
+ * Output:        values - Updated with the integers read.
+ * Return Values: The number of integers read. Where sscanf returns EOF on an
+ *                empty string this returns 0; both fail ValidateRead.
+ */
+static inline int ReadInts(const char *str, int *values, int count) {
+	for (int read = 0; read < count; read++) {
+		while (IsSpace(*str)) {
+			str++;
+		}
+		bool negative = (*str == '-');
+		if (*str == '-' || *str == '+') {
+			str++;
+		}
+		unsigned digit = (unsigned) (*str - '0');
+		if (digit > 9) {
+			return read;
+		}
+		// the magnitude saturates at that of LONG_MIN or LONG_MAX
+		unsigned long limit = negative ?
+				(unsigned long) LONG_MAX + 1 : (unsigned long) LONG_MAX;
+		unsigned long value = 0;
+		do {
+			if (value > limit / 10
+					|| (value == limit / 10 && digit > limit % 10)) {
+				value = limit;
+			} else {
+				value = value * 10 + digit;
+			}
+			digit = (unsigned) (*++str - '0');
+		} while (digit <= 9);
+		values[read] = (int) (unsigned) (negative ? 0ul - value : value);
+	}
+	return count;
+}
+
+#endif /* TOKENIZER_H_ */
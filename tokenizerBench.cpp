@@ -0,0 +1,74 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : tokenizerBench.cpp                                          */
+/*                                                                         */
+/* Compares the shell's argument parsing speed, in lines per second,       */
+/* between sscanf and ReadInts (tokenizer.h).                              */
+/*                                                                         */
+/* Usage: tokenizerBench [numOfLines]                                      */
+/***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "tokenizer.h"
+
+#define LINE_SIZE (64)
+
+static double SecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, const char**argv) {
+	int numOfLines = (argc > 1) ? atoi(argv[1]) : 2000000;
+	if (numOfLines <= 0) {
+		fprintf(stderr, "usage: %s [numOfLines]\n", argv[0]);
+		return 1;
+	}
+	// the arguments of CatchPokemon lines, as the handlers see them
+	char *lines = (char*) malloc((size_t) numOfLines * LINE_SIZE);
+	if (lines == NULL) {
+		fprintf(stderr, "allocation failed\n");
+		return 1;
+	}
+	srand(1);
+	for (int i = 0; i < numOfLines; i++) {
+		snprintf(lines + (size_t) i * LINE_SIZE, LINE_SIZE, "%d %d %d\n",
+				rand() % 1000000 + 1, rand() % 10000 + 1, rand() % 100 + 1);
+	}
+
+	long long scanfSum = 0;
+	std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	for (int i = 0; i < numOfLines; i++) {
+		int a, b, c;
+		if (sscanf(lines + (size_t) i * LINE_SIZE, "%d %d %d", &a, &b, &c)
+				== 3) {
+			scanfSum += a + b + c;
+		}
+	}
+	double scanfSeconds = SecondsSince(start);
+
+	long long readIntsSum = 0;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < numOfLines; i++) {
+		int args[3];
+		if (ReadInts(lines + (size_t) i * LINE_SIZE, args, 3) == 3) {
+			readIntsSum += args[0] + args[1] + args[2];
+		}
+	}
+	double readIntsSeconds = SecondsSince(start);
+
+	printf("lines\t\t%d\n", numOfLines);
+	printf("sscanf\t\t%.0f lines/sec\n", numOfLines / scanfSeconds);
+	printf("ReadInts\t%.0f lines/sec\n", numOfLines / readIntsSeconds);
+	printf("speedup\t\t%.1fx\n", scanfSeconds / readIntsSeconds);
+	free(lines);
+	if (scanfSum != readIntsSum) {
+		printf("results differ!\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,215 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : topWatch.cpp                                                */
+/*                                                                         */
+/* Top pokemon change notifications, described in topWatch.h.              */
+/***************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "topWatch.h"
+
+#define TOP_WATCH_INITIAL_CAPACITY (8)
+
+/* Reads the top pokemon of trainerID. a missing trainer has none. */
+static StatusType ReadTop(void *DS, int trainerID, int *pokemonID) {
+	StatusType res = GetTopPokemon(DS, trainerID, pokemonID);
+	if (res == FAILURE) {
+		*pokemonID = -1;
+		return SUCCESS;
+	}
+	return res;
+}
+
+/* Returns the position in byTrainer of the first subscription after
+ * (trainerID, id), in O(log s). */
+static int UpperBound(const TopWatch *watch, int trainerID, int id) {
+	int low = 0;
+	int high = watch->numOfActive;
+	while (low < high) {
+		int middle = low + (high - low) / 2;
+		int middleID = watch->byTrainer[middle];
+		int middleTrainer = watch->subscriptions[middleID].trainerID;
+		if (middleTrainer < trainerID
+				|| (middleTrainer == trainerID && middleID <= id)) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return low;
+}
+
+static int AddSubscription(TopWatch *watch, void *DS, int trainerID,
+		TopChangedCallback callback, void *context, int eventFd) {
+	int pokemonID;
+	trainerID = (trainerID < 0) ? -1 : trainerID;
+	if (ReadTop(DS, trainerID, &pokemonID) != SUCCESS) {
+		return -1;
+	}
+	// reuse the slot of a cancelled subscription before growing
+	int id = 0;
+	while (id < watch->numOfSubscriptions && watch->subscriptions[id].active) {
+		id++;
+	}
+	if (id == watch->capacity) {
+		int capacity = (watch->capacity == 0) ?
+				TOP_WATCH_INITIAL_CAPACITY : 2 * watch->capacity;
+		TopSubscription *subscriptions = (TopSubscription*) realloc(
+				watch->subscriptions, sizeof(TopSubscription) * capacity);
+		if (subscriptions == NULL) {
+			return -1;
+		}
+		watch->subscriptions = subscriptions;
+		int *byTrainer = (int*) realloc(watch->byTrainer,
+				sizeof(int) * capacity);
+		if (byTrainer == NULL) {
+			return -1;
+		}
+		watch->byTrainer = byTrainer;
+		watch->capacity = capacity;
+	}
+	if (id == watch->numOfSubscriptions) {
+		watch->numOfSubscriptions++;
+	}
+	TopSubscription *subscription = &watch->subscriptions[id];
+	subscription->trainerID = trainerID;
+	subscription->pokemonID = pokemonID;
+	subscription->callback = callback;
+	subscription->context = context;
+	subscription->eventFd = eventFd;
+	subscription->active = true;
+
+	int position = UpperBound(watch, trainerID, id);
+	memmove(watch->byTrainer + position + 1, watch->byTrainer + position,
+			sizeof(int) * (watch->numOfActive - position));
+	watch->byTrainer[position] = id;
+	watch->numOfActive++;
+	return id;
+}
+
+/***************************************************************************/
+/* TopWatchCreate                                                          */
+/***************************************************************************/
+TopWatch* TopWatchCreate() {
+	TopWatch *watch = (TopWatch*) malloc(sizeof(TopWatch));
+	if (watch == NULL) {
+		return NULL;
+	}
+	watch->subscriptions = NULL;
+	watch->numOfSubscriptions = 0;
+	watch->capacity = 0;
+	watch->byTrainer = NULL;
+	watch->numOfActive = 0;
+	return watch;
+}
+
+/***************************************************************************/
+/* TopWatchSubscribe                                                       */
+/***************************************************************************/
+int TopWatchSubscribe(TopWatch *watch, void *DS, int trainerID,
+		TopChangedCallback callback, void *context) {
+	if (watch == NULL || DS == NULL || callback == NULL || trainerID == 0) {
+		return -1;
+	}
+	return AddSubscription(watch, DS, trainerID, callback, context, -1);
+}
+
+int TopWatchSubscribeEventFd(TopWatch *watch, void *DS, int trainerID,
+		int *eventFd) {
+	if (watch == NULL || DS == NULL || eventFd == NULL || trainerID == 0) {
+		return -1;
+	}
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd < 0) {
+		return -1;
+	}
+	int id = AddSubscription(watch, DS, trainerID, NULL, NULL, fd);
+	if (id < 0) {
+		close(fd);
+		return -1;
+	}
+	*eventFd = fd;
+	return id;
+}
+
+/***************************************************************************/
+/* TopWatchUnsubscribe                                                     */
+/***************************************************************************/
+StatusType TopWatchUnsubscribe(TopWatch *watch, int subscriptionID) {
+	if (watch == NULL) {
+		return INVALID_INPUT;
+	}
+	if (subscriptionID < 0 || subscriptionID >= watch->numOfSubscriptions
+			|| !watch->subscriptions[subscriptionID].active) {
+		return FAILURE;
+	}
+	TopSubscription *subscription = &watch->subscriptions[subscriptionID];
+	if (subscription->eventFd >= 0) {
+		close(subscription->eventFd);
+	}
+	// the subscription is the one just before its upper bound
+	int position = UpperBound(watch, subscription->trainerID,
+			subscriptionID) - 1;
+	memmove(watch->byTrainer + position, watch->byTrainer + position + 1,
+			sizeof(int) * (watch->numOfActive - position - 1));
+	watch->numOfActive--;
+	subscription->active = false;
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* TopWatchNotify                                                          */
+/***************************************************************************/
+void TopWatchNotify(TopWatch *watch, int trainerID, int pokemonID) {
+	if (watch == NULL) {
+		return;
+	}
+	// the next subscription is looked up again after every notification, as
+	// a callback may (un)subscribe and move the others in byTrainer
+	int id = -1;
+	while (true) {
+		int position = UpperBound(watch, trainerID, id);
+		if (position == watch->numOfActive) {
+			return;
+		}
+		id = watch->byTrainer[position];
+		TopSubscription *subscription = &watch->subscriptions[id];
+		if (subscription->trainerID != trainerID) {
+			return;
+		}
+		if (subscription->pokemonID == pokemonID) {
+			continue;
+		}
+		subscription->pokemonID = pokemonID;
+		if (subscription->eventFd >= 0) {
+			uint64_t one = 1;
+			// a full counter already tells the client to look again
+			ssize_t written = write(subscription->eventFd, &one, sizeof(one));
+			(void) written;
+		} else {
+			// the callback may (un)subscribe, so the slot isn't used after it
+			subscription->callback(trainerID, pokemonID,
+					subscription->context);
+		}
+	}
+}
+
+/***************************************************************************/
+/* TopWatchDestroy                                                         */
+/***************************************************************************/
+void TopWatchDestroy(TopWatch **watch) {
+	if (watch == NULL || *watch == NULL) {
+		return;
+	}
+	for (int id = 0; id < (*watch)->numOfSubscriptions; id++) {
+		TopWatchUnsubscribe(*watch, id);
+	}
+	free((*watch)->subscriptions);
+	free((*watch)->byTrainer);
+	free(*watch);
+	*watch = NULL;
+}
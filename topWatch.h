@@ -0,0 +1,107 @@
+#ifndef TOPWATCH_H_
+#define TOPWATCH_H_
+#include "library1.h"
+
+/*
+ * Top pokemon notifications - lets clients learn that the top pokemon of the
+ * DS, or of a trainer, changed without polling GetTopPokemon.
+ *
+ * A DS with a watch attached (see SetTopWatch in library1.h) compares, in
+ * every successful mutation, the top pokemon of each trainer the mutation
+ * touched and of the whole DS before and after it (O(1) each), and calls
+ * TopWatchNotify only for the ones that changed. The watch keeps its
+ * subscriptions sorted by trainer, so a notification costs O(log s) for s
+ * subscriptions plus the subscriptions it reaches, and a mutation that
+ * doesn't change a top pokemon costs nothing. A subscriber is reached either
+ * through a callback or by signaling an eventfd the client can poll/epoll on.
+ */
+
+/* Called when the top pokemon of trainerID (-1 for the whole DS) changed.
+ * pokemonID is the new top pokemon, or -1 if there is none. */
+typedef void (*TopChangedCallback)(int trainerID, int pokemonID, void *context);
+
+typedef struct {
+	int trainerID;
+	int pokemonID;
+	TopChangedCallback callback;
+	void *context;
+	int eventFd;
+	bool active;
+} TopSubscription;
+
+struct TopWatch {
+	TopSubscription *subscriptions;
+	int numOfSubscriptions;
+	int capacity;
+	// the IDs of the active subscriptions, sorted by (trainerID, ID)
+	int *byTrainer;
+	int numOfActive;
+};
+
+/* Description:   Creates an empty watch.
+ * Return Values: The watch, or NULL in case of an allocation error.
+ */
+TopWatch* TopWatchCreate();
+
+/* Description:   Subscribes a callback to the top pokemon of a trainer.
+ * Input:         watch - The watch.
+ *                DS - A pointer to the data structure, used to read the current top pokemon.
+ *                trainerID - The trainer to watch, or a negative ID for the whole DS.
+ *                callback - Called on every change.
+ *                context - Passed to callback.
+ * Output:        None.
+ * Return Values: The ID of the subscription, or -1 if any of the arguments is
+ *                NULL or trainerID == 0, or in case of an allocation error.
+ */
+int TopWatchSubscribe(TopWatch *watch, void *DS, int trainerID,
+		TopChangedCallback callback, void *context);
+
+/* Description:   Subscribes an eventfd to the top pokemon of a trainer. Every
+ *                change adds 1 to the eventfd counter; read it and call
+ *                GetTopPokemon to learn the new top pokemon.
+ * Input:         watch - The watch.
+ *                DS - A pointer to the data structure.
+ *                trainerID - The trainer to watch, or a negative ID for the whole DS.
+ * Output:        eventFd - Updated to the non blocking eventfd of the
+ *                subscription. It is closed by TopWatchUnsubscribe.
+ * Return Values: The ID of the subscription, or -1 if any of the arguments is
+ *                NULL or trainerID == 0, creating the eventfd failed, or in
+ *                case of an allocation error.
+ */
+int TopWatchSubscribeEventFd(TopWatch *watch, void *DS, int trainerID,
+		int *eventFd);
+
+/* Description:   Cancels a subscription.
+ * Input:         watch - The watch.
+ *                subscriptionID - The ID returned when subscribing.
+ * Output:        None.
+ * Return Values: INVALID_INPUT - If watch==NULL.
+ *                FAILURE - If there is no such subscription.
+ *                SUCCESS - Otherwise.
+ */
+StatusType TopWatchUnsubscribe(TopWatch *watch, int subscriptionID);
+
+/* Description:   Notifies the subscriptions of a trainer that its top pokemon
+ *                changed. Called by the DS from its mutation paths; a
+ *                subscription already holding pokemonID isn't notified again.
+ *                Callbacks may subscribe and unsubscribe, but must not
+ *                mutate the DS.
+ * Input:         watch - The watch.
+ *                trainerID - The trainer, or -1 for the whole DS.
+ *                pokemonID - The new top pokemon, or -1 if there is none (or
+ *                the trainer was removed).
+ * Output:        None.
+ * Return Values: None.
+ */
+void TopWatchNotify(TopWatch *watch, int trainerID, int pokemonID);
+
+/* Description:   Cancels all the subscriptions and releases the watch.
+ *                watch should be set to NULL. Detach it from the DS
+ *                (SetTopWatch(DS, NULL)) first.
+ * Input:         watch - A pointer to the watch.
+ * Output:        None.
+ * Return Values: None.
+ */
+void TopWatchDestroy(TopWatch **watch);
+
+#endif /* TOPWATCH_H_ */
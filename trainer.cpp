@@ -0,0 +1,83 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : trainer.cpp                                                 */
+/*                                                                         */
+/* The trainers of the DS and their level indexes, described in trainer.h. */
+/***************************************************************************/
+
+#include <algorithm>
+#include "trainer.h"
+
+/***************************************************************************/
+/* LevelIndex                                                              */
+/***************************************************************************/
+long long LevelIndex::updateLevels(int stoneCode, int stoneFactor,
+		LevelKey *scratch) {
+	int size = keys.size();
+	int numOfUpdated = 0;
+	for (Iterator<LevelKey> iter = keys.begin(); iter != keys.end(); ++iter) {
+		numOfUpdated += (iter.get()->pokemonID % stoneCode == 0);
+	}
+	if (numOfUpdated == 0) {
+		return 0;
+	}
+
+	// the unchanged keys go to the end of merged, the updated ones to updated
+	LevelKey *merged = scratch;
+	LevelKey *updated = scratch + size;
+	int unchanged = numOfUpdated;
+	int next = 0;
+	long long levelsDelta = 0;
+	for (Iterator<LevelKey> iter = keys.begin(); iter != keys.end(); ++iter) {
+		const LevelKey& key = *iter.get();
+		if (key.pokemonID % stoneCode == 0) {
+			updated[next] = LevelKey(MultiplyLevel(key.level, stoneFactor),
+					key.pokemonID);
+			levelsDelta += (long long) updated[next].level - key.level;
+			next++;
+		} else {
+			merged[unchanged++] = key;
+		}
+	}
+	// multiplying keeps the order, unless a level wrapped around
+	if (!std::is_sorted(updated, updated + numOfUpdated)) {
+		std::sort(updated, updated + numOfUpdated);
+	}
+
+	// merge from the front: the write position never passes the next
+	// unchanged key, which starts numOfUpdated keys ahead
+	int first = numOfUpdated;
+	int second = 0;
+	for (int i = 0; i < size; i++) {
+		if (second == numOfUpdated
+				|| (first < size && !(updated[second] < merged[first]))) {
+			merged[i] = merged[first++];
+		} else {
+			merged[i] = updated[second++];
+		}
+	}
+	// the same number of keys, so the build reuses the index's own nodes
+	keys.buildFromSorted(merged, size);
+	return levelsDelta;
+}
+
+/***************************************************************************/
+/* Trainer                                                                 */
+/***************************************************************************/
+Trainer::Trainer(int id) :
+		id(id) {
+}
+
+Trainer::Trainer(const Trainer& trainer) :
+		id(trainer.id), pokemons(trainer.pokemons), stats(trainer.stats) {
+}
+
+Trainer& Trainer::operator=(const Trainer& trainer) {
+	id = trainer.id;
+	pokemons = trainer.pokemons;
+	stats = trainer.stats;
+	return *this;
+}
+
+Trainer::~Trainer() {
+}
@@ -1,13 +1,219 @@
 #ifndef TRAINER_H_
 #define TRAINER_H_
+#include "avlTree.h"
+#include "pokemon.h"
+
+/**
+ * TrainerStats - the statistics of a group of pokemons (a trainer's, or all
+ * the pokemons of the DS), kept up to date by every mutation so reading them
+ * is O(1).
+ */
+struct TrainerStats {
+	int numOfPokemons;
+	long long sumOfLevels;
+	int maxLevel;
+
+	TrainerStats() :
+			numOfPokemons(0), sumOfLevels(0), maxLevel(0) {
+	}
+
+	/**
+	 * add - account for a pokemon joining the group.
+	 * @param level - the level of the pokemon.
+	 */
+	void add(int level) {
+		if (numOfPokemons == 0 || level > maxLevel) {
+			maxLevel = level;
+		}
+		numOfPokemons++;
+		sumOfLevels += level;
+	}
+
+	/**
+	 * remove - account for a pokemon leaving the group.
+	 * @param level - the level of the pokemon.
+	 * @param newMaxLevel - the highest level left in the group (0 if empty),
+	 * 						read in O(1) from the group's level index.
+	 */
+	void remove(int level, int newMaxLevel) {
+		numOfPokemons--;
+		sumOfLevels -= level;
+		maxLevel = newMaxLevel;
+	}
+
+	/**
+	 * addGroup - account for all the pokemons of another group joining this
+	 * one, as in TransferAll.
+	 * @param newMaxLevel - the highest level in the group after the change.
+	 */
+	void addGroup(const TrainerStats& group, int newMaxLevel) {
+		numOfPokemons += group.numOfPokemons;
+		sumOfLevels += group.sumOfLevels;
+		maxLevel = newMaxLevel;
+	}
+
+	/**
+	 * removeGroup - account for all the pokemons of another group, which are
+	 * part of this one, leaving it, as in RemoveTrainer.
+	 * @param newMaxLevel - the highest level left in the group (0 if empty).
+	 */
+	void removeGroup(const TrainerStats& group, int newMaxLevel) {
+		numOfPokemons -= group.numOfPokemons;
+		sumOfLevels -= group.sumOfLevels;
+		maxLevel = newMaxLevel;
+	}
+
+	/**
+	 * changeLevels - account for the levels of some pokemons of the group
+	 * changing, as in LevelUp or UpdateLevels.
+	 * @param levelsDelta - the sum of the changes to the levels.
+	 * @param newMaxLevel - the highest level in the group after the change.
+	 */
+	void changeLevels(long long levelsDelta, int newMaxLevel) {
+		sumOfLevels += levelsDelta;
+		maxLevel = newMaxLevel;
+	}
+};
+
+/**
+ * LevelIndex - the pokemons of a trainer, or all the pokemons of the DS, in
+ * level order (see LevelKey).
+ */
+class LevelIndex {
+	AvlTree<LevelKey> keys;
+
+public:
+	/**
+	 * reserve - make sure count keys can be added without allocating memory.
+	 * @return - false if the allocation failed (the index is unchanged).
+	 */
+	bool reserve(int count) {
+		return keys.reserve(count);
+	}
+
+	/**
+	 * add - add a key. room for it must have been reserved, so it never fails.
+	 */
+	void add(const LevelKey& key) {
+		keys.tryInsert(key);
+	}
+
+	/**
+	 * remove - remove a key that is in the index. the key's node goes back to
+	 * the reserve, so a key can always be added in its place.
+	 */
+	void remove(const LevelKey& key) {
+		keys.tryRemove(keys.search(key));
+	}
+
+	/**
+	 * top - returns the ID of the pokemon with the highest level, or -1 if
+	 * the index is empty, in O(1).
+	 */
+	int top() {
+		LevelKey *key = keys.begin().get();
+		return (key == nullptr) ? -1 : key->pokemonID;
+	}
+
+	/**
+	 * maxLevel - returns the level of the top pokemon, or 0 if the index is
+	 * empty, in O(1).
+	 */
+	int maxLevel() {
+		LevelKey *key = keys.begin().get();
+		return (key == nullptr) ? 0 : key->level;
+	}
+
+	/**
+	 * merge - move all the keys of another index into this one, in
+	 * O(size() + other.size()). other is left empty.
+	 * @return - false if the allocation failed (both are unchanged).
+	 */
+	bool merge(LevelIndex& other) {
+		return keys.merge(other.keys);
+	}
+
+	/**
+	 * removeSorted - remove count keys, already in level order, that are in
+	 * the index, one by one or in a single pass (see AvlTree::removeSorted).
+	 * never fails.
+	 */
+	void removeSorted(const LevelKey *sorted, int count) {
+		keys.removeSorted(sorted, count);
+	}
+
+	/**
+	 * build - replace the keys of the index with count keys already in level
+	 * order, in O(count).
+	 * @return - false if the allocation failed (the index is unchanged).
+	 */
+	bool build(const LevelKey *sorted, int count) {
+		return keys.buildFromSorted(sorted, count);
+	}
+
+	int size() const {
+		return keys.size();
+	}
+
+	Iterator<LevelKey> begin() {
+		return keys.begin();
+	}
+
+	Iterator<LevelKey> end() {
+		return keys.end();
+	}
+
+	/**
+	 * updateLevels - multiply by stoneFactor the levels of the pokemons whose
+	 * ID is divisible by stoneCode, in O(size). the updated and the unchanged
+	 * keys are both still in level order, so they are merged and the index is
+	 * rebuilt in place. nothing is allocated.
+	 * @param scratch - room for 2 * size() keys.
+	 * @return - the sum of the changes to the levels, for TrainerStats.
+	 */
+	long long updateLevels(int stoneCode, int stoneFactor, LevelKey *scratch);
+};
 
 class Trainer {
+	int id;
+	LevelIndex pokemons;
+	TrainerStats stats;
 
 public:
-	Trainer();
+	explicit Trainer(int id = 0);
 	Trainer(const Trainer& trainer);
 	Trainer& operator=(const Trainer& trainer);
 	virtual ~Trainer();
-}
+
+	int getID() const {
+		return id;
+	}
+
+	/**
+	 * getPokemons - returns the trainer's level index.
+	 */
+	LevelIndex& getPokemons() {
+		return pokemons;
+	}
+
+	/**
+	 * getStats - returns the statistics of the trainer's pokemons.
+	 */
+	const TrainerStats& getStats() const {
+		return stats;
+	}
+
+	TrainerStats& getStats() {
+		return stats;
+	}
+
+	/**
+	 * operator< - trainers are ordered by their ID, so a Trainer holding only
+	 * an ID is enough to look one up.
+	 */
+	bool operator<(const Trainer& trainer) const {
+		return id < trainer.id;
+	}
+};
 
 #endif /* TRAINER_H_ */
@@ -0,0 +1,173 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : trainerStatsTest.cpp                                        */
+/*                                                                         */
+/* Tests of GetTrainerStats (see library1.h): the count, sum and highest  */
+/* level of every trainer and of the whole DS follow every mutation,      */
+/* including UpdateLevels, the transfers, RemoveTrainer and a snapshot    */
+/* round trip.                                                             */
+/*                                                                         */
+/* Usage: trainerStatsTest                                                 */
+/*                                                                         */
+/* Built from trainerStatsTest.cpp and library1.cpp with its dependencies. */
+/* Prints every failed check and exits with 1 if any failed, 0 otherwise. */
+/***************************************************************************/
+
+#include <stdio.h>
+#include <unistd.h>
+#include "library1.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+					#condition); \
+			failures++; \
+		} \
+	} while (0)
+
+/* Checks the statistics GetTrainerStats returns for trainerID. */
+#define CHECK_STATS(DS, trainerID, count, sum, max) \
+	do { \
+		int numOfPokemon = -1; \
+		long long sumOfLevels = -1; \
+		int maxLevel = -1; \
+		CHECK(GetTrainerStats(DS, trainerID, &numOfPokemon, &sumOfLevels, \
+				&maxLevel) == SUCCESS); \
+		CHECK(numOfPokemon == (count)); \
+		CHECK(sumOfLevels == (sum)); \
+		CHECK(maxLevel == (max)); \
+	} while (0)
+
+static void TestInvalid(void *DS) {
+	int numOfPokemon;
+	long long sumOfLevels;
+	int maxLevel;
+	CHECK(GetTrainerStats(NULL, 1, &numOfPokemon, &sumOfLevels, &maxLevel)
+			== INVALID_INPUT);
+	CHECK(GetTrainerStats(DS, 0, &numOfPokemon, &sumOfLevels, &maxLevel)
+			== INVALID_INPUT);
+	CHECK(GetTrainerStats(DS, 1, NULL, &sumOfLevels, &maxLevel)
+			== INVALID_INPUT);
+	CHECK(GetTrainerStats(DS, 1, &numOfPokemon, NULL, &maxLevel)
+			== INVALID_INPUT);
+	CHECK(GetTrainerStats(DS, 1, &numOfPokemon, &sumOfLevels, NULL)
+			== INVALID_INPUT);
+	CHECK(GetTrainerStats(DS, 99, &numOfPokemon, &sumOfLevels, &maxLevel)
+			== FAILURE);
+}
+
+static void TestMutations() {
+	void *DS = Init();
+	CHECK(DS != NULL);
+	if (DS == NULL) {
+		return;
+	}
+	TestInvalid(DS);
+	CHECK_STATS(DS, -1, 0, 0, 0);
+
+	CHECK(AddTrainer(DS, 1) == SUCCESS);
+	CHECK(AddTrainer(DS, 2) == SUCCESS);
+	CHECK_STATS(DS, 1, 0, 0, 0);
+
+	// catch
+	CHECK(CatchPokemon(DS, 10, 1, 5) == SUCCESS);
+	CHECK(CatchPokemon(DS, 11, 1, 9) == SUCCESS);
+	CHECK(CatchPokemon(DS, 12, 1, 2) == SUCCESS);
+	CHECK(CatchPokemon(DS, 20, 2, 7) == SUCCESS);
+	CHECK(CatchPokemon(DS, 10, 2, 1) == FAILURE);
+	CHECK_STATS(DS, 1, 3, 16, 9);
+	CHECK_STATS(DS, 2, 1, 7, 7);
+	CHECK_STATS(DS, -1, 4, 23, 9);
+
+	// free the top pokemon, so the highest level drops
+	CHECK(FreePokemon(DS, 11) == SUCCESS);
+	CHECK_STATS(DS, 1, 2, 7, 5);
+	CHECK_STATS(DS, -1, 3, 14, 7);
+
+	// level up past the top
+	CHECK(LevelUp(DS, 12, 6) == SUCCESS);
+	CHECK_STATS(DS, 1, 2, 13, 8);
+	CHECK_STATS(DS, -1, 3, 20, 8);
+
+	// evolving keeps the level
+	CHECK(EvolvePokemon(DS, 12, 30) == SUCCESS);
+	CHECK_STATS(DS, 1, 2, 13, 8);
+
+	// update the IDs divisible by 10: 10 (5 -> 15), 20 (7 -> 21), 30 (8 -> 24)
+	CHECK(UpdateLevels(DS, 10, 3) == SUCCESS);
+	CHECK_STATS(DS, 1, 2, 39, 24);
+	CHECK_STATS(DS, 2, 1, 21, 21);
+	CHECK_STATS(DS, -1, 3, 60, 24);
+
+	// transfers move the statistics between trainers only
+	CHECK(TransferPokemon(DS, 30, 2) == SUCCESS);
+	CHECK_STATS(DS, 1, 1, 15, 15);
+	CHECK_STATS(DS, 2, 2, 45, 24);
+	CHECK_STATS(DS, -1, 3, 60, 24);
+	CHECK(TransferAll(DS, 2, 1) == SUCCESS);
+	CHECK_STATS(DS, 1, 3, 60, 24);
+	CHECK_STATS(DS, 2, 0, 0, 0);
+	CHECK(TransferAll(DS, 1, 1) == SUCCESS);
+	CHECK_STATS(DS, 1, 3, 60, 24);
+
+	// a snapshot restores the statistics too
+	const char *path = "trainerStatsTest.snapshot";
+	CHECK(SaveSnapshot(DS, path) == SUCCESS);
+	void *loaded = LoadSnapshot(path);
+	unlink(path);
+	CHECK(loaded != NULL);
+	if (loaded != NULL) {
+		CHECK_STATS(loaded, 1, 3, 60, 24);
+		CHECK_STATS(loaded, 2, 0, 0, 0);
+		CHECK_STATS(loaded, -1, 3, 60, 24);
+		Quit(&loaded);
+	}
+
+	// removing a trainer takes its pokemons out of the whole DS's statistics
+	CHECK(CatchPokemon(DS, 40, 2, 4) == SUCCESS);
+	CHECK(RemoveTrainer(DS, 1) == SUCCESS);
+	CHECK_STATS(DS, -1, 1, 4, 4);
+	int numOfPokemon;
+	long long sumOfLevels;
+	int maxLevel;
+	CHECK(GetTrainerStats(DS, 1, &numOfPokemon, &sumOfLevels, &maxLevel)
+			== FAILURE);
+	CHECK(FreePokemon(DS, 40) == SUCCESS);
+	CHECK_STATS(DS, 2, 0, 0, 0);
+	CHECK_STATS(DS, -1, 0, 0, 0);
+	Quit(&DS);
+}
+
+/* A sum beyond int: it has to be accumulated in a long long. */
+static void TestLargeSum() {
+	void *DS = Init();
+	CHECK(DS != NULL);
+	if (DS == NULL) {
+		return;
+	}
+	CHECK(AddTrainer(DS, 1) == SUCCESS);
+	const int numOfPokemons = 1000;
+	const int level = 1 << 28;
+	for (int i = 1; i <= numOfPokemons; i++) {
+		CHECK(CatchPokemon(DS, i, 1, level) == SUCCESS);
+	}
+	CHECK_STATS(DS, 1, numOfPokemons, (long long) numOfPokemons * level, level);
+	CHECK(LevelUp(DS, 7, 1) == SUCCESS);
+	CHECK_STATS(DS, -1, numOfPokemons, (long long) numOfPokemons * level + 1,
+			level + 1);
+	Quit(&DS);
+}
+
+int main() {
+	TestMutations();
+	TestLargeSum();
+	if (failures > 0) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	printf("trainerStatsTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,371 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : wal.cpp                                                     */
+/*                                                                         */
+/* The write-ahead log of the DS mutations described in wal.h.             */
+/***************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "wal.h"
+
+/***************************************************************************/
+/* Record encoding                                                         */
+/***************************************************************************/
+
+/* CRC-32 (IEEE 802.3) of size bytes. */
+static uint32_t Crc32(const unsigned char *data, size_t size) {
+	static uint32_t table[256];
+	static bool tableReady = false;
+	if (!tableReady) {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t crc = i;
+			for (int bit = 0; bit < 8; bit++) {
+				crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+			}
+			table[i] = crc;
+		}
+		tableReady = true;
+	}
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFFu;
+}
+
+/* Returns the number of arguments of a record, or -1 for an unknown op. */
+static int WalNumOfArgs(int op) {
+	switch (op) {
+	case WAL_ADD_TRAINER:
+	case WAL_FREE_POKEMON:
+	case WAL_REMOVE_TRAINER:
+		return 1;
+	case WAL_LEVEL_UP:
+	case WAL_EVOLVE_POKEMON:
+	case WAL_UPDATE_LEVELS:
+	case WAL_TRANSFER_POKEMON:
+	case WAL_TRANSFER_ALL:
+		return 2;
+	case WAL_CATCH_POKEMON:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+static int64_t NowMs() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/* Appends a record, committing the group if it is complete or waited
+ * maxDelayMs. Returns the result of that commit, or SUCCESS if the record is
+ * left pending. Nothing else checks the delay (see wal.h). */
+static StatusType WalAppend(Wal *wal, WalOp op, int arg0, int arg1, int arg2) {
+	const int32_t args[WAL_MAX_ARGS] = { arg0, arg1, arg2 };
+	int numOfArgs = WalNumOfArgs(op);
+	unsigned char *record = (unsigned char*) wal->buffer + wal->used;
+	record[0] = (unsigned char) op;
+	memcpy(record + 1, args, sizeof(int32_t) * numOfArgs);
+	size_t size = 1 + sizeof(int32_t) * numOfArgs;
+	uint32_t crc = Crc32(record, size);
+	memcpy(record + size, &crc, sizeof(crc));
+	wal->used += size + sizeof(crc);
+
+	if (wal->pendingRecords++ == 0) {
+		wal->firstPendingTime = (wal->maxDelayMs > 0) ? NowMs() : 0;
+	}
+	if (wal->pendingRecords >= wal->groupSize
+			|| (wal->maxDelayMs > 0
+					&& NowMs() - wal->firstPendingTime >= wal->maxDelayMs)) {
+		return WalCommit(wal);
+	}
+	return SUCCESS;
+}
+
+/***************************************************************************/
+/* WalOpen                                                                 */
+/***************************************************************************/
+Wal* WalOpen(const char *path, int groupSize, int maxDelayMs) {
+	if (path == NULL || groupSize < 1 || maxDelayMs < 0) {
+		return NULL;
+	}
+	Wal *wal = (Wal*) malloc(sizeof(Wal));
+	if (wal == NULL) {
+		return NULL;
+	}
+	wal->capacity = (size_t) groupSize * WAL_MAX_RECORD_SIZE;
+	wal->buffer = (char*) malloc(wal->capacity);
+	wal->fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+	if (wal->buffer == NULL || wal->fd < 0) {
+		if (wal->fd >= 0) {
+			close(wal->fd);
+		}
+		free(wal->buffer);
+		free(wal);
+		return NULL;
+	}
+	wal->used = 0;
+	wal->pendingRecords = 0;
+	wal->groupSize = groupSize;
+	wal->maxDelayMs = maxDelayMs;
+	wal->firstPendingTime = 0;
+	wal->failed = false;
+	return wal;
+}
+
+/***************************************************************************/
+/* WalCommit                                                               */
+/***************************************************************************/
+StatusType WalCommit(Wal *wal) {
+	if (wal == NULL) {
+		return INVALID_INPUT;
+	}
+	if (wal->pendingRecords > 0) {
+		size_t written = 0;
+		while (written < wal->used && !wal->failed) {
+			ssize_t res = write(wal->fd, wal->buffer + written,
+					wal->used - written);
+			if (res < 0 && errno != EINTR) {
+				wal->failed = true;
+			} else if (res > 0) {
+				written += res;
+			}
+		}
+		if (!wal->failed && fdatasync(wal->fd) != 0) {
+			wal->failed = true;
+		}
+		wal->used = 0;
+		wal->pendingRecords = 0;
+	}
+	return wal->failed ? FAILURE : SUCCESS;
+}
+
+/***************************************************************************/
+/* WalClose                                                                */
+/***************************************************************************/
+void WalClose(Wal **wal) {
+	if (wal == NULL || *wal == NULL) {
+		return;
+	}
+	WalCommit(*wal);
+	close((*wal)->fd);
+	free((*wal)->buffer);
+	free(*wal);
+	*wal = NULL;
+}
+
+/***************************************************************************/
+/* WalReplay                                                               */
+/***************************************************************************/
+static StatusType WalApply(void *DS, int op, const int32_t *args) {
+	switch (op) {
+	case WAL_ADD_TRAINER:
+		return AddTrainer(DS, args[0]);
+	case WAL_CATCH_POKEMON:
+		return CatchPokemon(DS, args[0], args[1], args[2]);
+	case WAL_FREE_POKEMON:
+		return FreePokemon(DS, args[0]);
+	case WAL_LEVEL_UP:
+		return LevelUp(DS, args[0], args[1]);
+	case WAL_EVOLVE_POKEMON:
+		return EvolvePokemon(DS, args[0], args[1]);
+	case WAL_UPDATE_LEVELS:
+		return UpdateLevels(DS, args[0], args[1]);
+	case WAL_TRANSFER_POKEMON:
+		return TransferPokemon(DS, args[0], args[1]);
+	case WAL_TRANSFER_ALL:
+		return TransferAll(DS, args[0], args[1]);
+	case WAL_REMOVE_TRAINER:
+		return RemoveTrainer(DS, args[0]);
+	default:
+		return FAILURE;
+	}
+}
+
+StatusType WalReplay(const char *path, void *DS, int *numOfRecords) {
+	if (path == NULL || DS == NULL) {
+		return INVALID_INPUT;
+	}
+	if (numOfRecords != NULL) {
+		*numOfRecords = 0;
+	}
+	int fd = open(path, O_RDWR);
+	if (fd < 0) {
+		return (errno == ENOENT) ? SUCCESS : FAILURE;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0) {
+		close(fd);
+		return FAILURE;
+	}
+	size_t size = fileStat.st_size;
+	unsigned char *log = (unsigned char*) malloc(size + 1);
+	if (log == NULL) {
+		close(fd);
+		return ALLOCATION_ERROR;
+	}
+	size_t readSize = 0;
+	while (readSize < size) {
+		ssize_t res = read(fd, log + readSize, size - readSize);
+		if (res == 0 || (res < 0 && errno != EINTR)) {
+			break;
+		}
+		readSize += (res > 0) ? res : 0;
+	}
+	// a short read isn't a torn tail: apply nothing and keep the whole log
+	if (readSize < size) {
+		free(log);
+		close(fd);
+		return FAILURE;
+	}
+
+	size_t position = 0;
+	int applied = 0;
+	StatusType res = SUCCESS;
+	while (position < size) {
+		int numOfArgs = WalNumOfArgs(log[position]);
+		size_t recordSize = 1 + sizeof(int32_t) * numOfArgs;
+		uint32_t crc;
+		if (numOfArgs < 0 || position + recordSize + sizeof(crc) > size) {
+			break;
+		}
+		memcpy(&crc, log + position + recordSize, sizeof(crc));
+		if (crc != Crc32(log + position, recordSize)) {
+			break;
+		}
+		int32_t args[WAL_MAX_ARGS];
+		memcpy(args, log + position + 1, sizeof(int32_t) * numOfArgs);
+		// only mutations that succeeded are logged, so one that fails now
+		// means the DS isn't the one the log was written against
+		res = WalApply(DS, log[position], args);
+		if (res != SUCCESS) {
+			break;
+		}
+		position += recordSize + sizeof(crc);
+		applied++;
+	}
+	free(log);
+
+	// drop the torn or corrupted tail, so new records follow intact ones
+	if (res == SUCCESS && position != size && ftruncate(fd, position) != 0) {
+		res = FAILURE;
+	}
+	close(fd);
+	if (numOfRecords != NULL) {
+		*numOfRecords = applied;
+	}
+	return res;
+}
+
+/***************************************************************************/
+/* Logged mutations                                                        */
+/***************************************************************************/
+StatusType WalAddTrainer(Wal *wal, void *DS, int trainerID) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = AddTrainer(DS, trainerID);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_ADD_TRAINER, trainerID, 0, 0);
+	}
+	return res;
+}
+
+StatusType WalRemoveTrainer(Wal *wal, void *DS, int trainerID) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = RemoveTrainer(DS, trainerID);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_REMOVE_TRAINER, trainerID, 0, 0);
+	}
+	return res;
+}
+
+StatusType WalCatchPokemon(Wal *wal, void *DS, int pokemonID, int trainerID,
+		int level) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = CatchPokemon(DS, pokemonID, trainerID, level);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_CATCH_POKEMON, pokemonID, trainerID, level);
+	}
+	return res;
+}
+
+StatusType WalFreePokemon(Wal *wal, void *DS, int pokemonID) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = FreePokemon(DS, pokemonID);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_FREE_POKEMON, pokemonID, 0, 0);
+	}
+	return res;
+}
+
+StatusType WalLevelUp(Wal *wal, void *DS, int pokemonID, int levelIncrease) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = LevelUp(DS, pokemonID, levelIncrease);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_LEVEL_UP, pokemonID, levelIncrease, 0);
+	}
+	return res;
+}
+
+StatusType WalEvolvePokemon(Wal *wal, void *DS, int pokemonID, int evolvedID) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = EvolvePokemon(DS, pokemonID, evolvedID);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_EVOLVE_POKEMON, pokemonID, evolvedID, 0);
+	}
+	return res;
+}
+
+StatusType WalUpdateLevels(Wal *wal, void *DS, int stoneCode, int stoneFactor) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = UpdateLevels(DS, stoneCode, stoneFactor);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_UPDATE_LEVELS, stoneCode, stoneFactor, 0);
+	}
+	return res;
+}
+
+StatusType WalTransferPokemon(Wal *wal, void *DS, int pokemonID,
+		int newTrainerID) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = TransferPokemon(DS, pokemonID, newTrainerID);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_TRANSFER_POKEMON, pokemonID, newTrainerID, 0);
+	}
+	return res;
+}
+
+StatusType WalTransferAll(Wal *wal, void *DS, int fromTrainerID,
+		int toTrainerID) {
+	if (wal != NULL && wal->failed) {
+		return FAILURE;
+	}
+	StatusType res = TransferAll(DS, fromTrainerID, toTrainerID);
+	if (res == SUCCESS && wal != NULL) {
+		res = WalAppend(wal, WAL_TRANSFER_ALL, fromTrainerID, toTrainerID, 0);
+	}
+	return res;
+}
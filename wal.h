@@ -0,0 +1,123 @@
+#ifndef WAL_H_
+#define WAL_H_
+#include <stddef.h>
+#include <stdint.h>
+#include "library1.h"
+
+/*
+ * Write-ahead log of the DS mutations.
+ *
+ * The Wal* functions below sit in front of the library1.h mutation functions:
+ * each one applies the mutation to the DS and, if it succeeded, appends a
+ * record of it to the log. Records are buffered and written with a single
+ * write + fdatasync per group (group commit), once groupSize records are
+ * pending, when a record is appended maxDelayMs or more after the first
+ * pending one, or on WalCommit. The delay is only checked by the next
+ * append: the log has no timer, so a group that stops growing stays in
+ * memory until the caller commits it. Callers call WalCommit themselves
+ * when they go idle, and WalClose on shutdown. A mutation is durable once
+ * the group it belongs to is committed. Once a commit fails the log is
+ * failed: its records are lost, and every later logged mutation is refused.
+ *
+ * A record is an opcode byte, the int32 arguments of the mutation (their
+ * number is given by the opcode) and a CRC-32 of the opcode and arguments.
+ * On startup WalReplay applies every intact record to a DS and cuts the log
+ * at the first torn or corrupted one.
+ */
+
+typedef enum {
+	WAL_ADD_TRAINER = 1,
+	WAL_CATCH_POKEMON = 2,
+	WAL_FREE_POKEMON = 3,
+	WAL_LEVEL_UP = 4,
+	WAL_EVOLVE_POKEMON = 5,
+	WAL_UPDATE_LEVELS = 6,
+	WAL_TRANSFER_POKEMON = 7,
+	WAL_TRANSFER_ALL = 8,
+	WAL_REMOVE_TRAINER = 9
+} WalOp;
+
+#define WAL_MAX_ARGS       (3)
+#define WAL_MAX_RECORD_SIZE (1 + 4 * WAL_MAX_ARGS + 4)
+
+typedef struct {
+	int fd;
+	char *buffer;
+	size_t used;
+	size_t capacity;
+	int pendingRecords;
+	int groupSize;
+	int maxDelayMs;
+	int64_t firstPendingTime;
+	bool failed;
+} Wal;
+
+/* Description:   Opens a log for appending, creating it if needed. Replay
+ *                the existing log with WalReplay before opening it.
+ * Input:         path - The log file.
+ *                groupSize - The number of records committed together (at least 1).
+ *                maxDelayMs - Commit the group with the first record appended
+ *                this long after the group's first record, even if the group
+ *                isn't full. 0 for no limit. Checked only on append, so a
+ *                pending group is committed only by a later append, WalCommit
+ *                or WalClose.
+ * Output:        None.
+ * Return Values: The open log, or NULL if path==NULL, groupSize < 1,
+ *                maxDelayMs < 0, the file can't be opened or in case of an allocation error.
+ */
+Wal* WalOpen(const char *path, int groupSize, int maxDelayMs);
+
+/* Description:   Writes the pending records and syncs them to disk.
+ * Input:         wal - The log.
+ * Output:        None.
+ * Return Values: INVALID_INPUT - If wal==NULL.
+ *                FAILURE - If writing the log failed, now or in an earlier
+ *                commit. Records of a failed commit are lost.
+ *                SUCCESS - Otherwise.
+ */
+StatusType WalCommit(Wal *wal);
+
+/* Description:   Commits the pending records and closes the log.
+ *                wal should be set to NULL.
+ * Input:         wal - A pointer to the log.
+ * Output:        None.
+ * Return Values: None.
+ */
+void WalClose(Wal **wal);
+
+/* Description:   Applies every intact record of a log to a DS, in order, and
+ *                truncates the log after the last intact record. Replay stops
+ *                at the first record whose mutation doesn't succeed, and the
+ *                log is then left as it is.
+ * Input:         path - The log file. A missing file is an empty log.
+ *                DS - A pointer to the data structure.
+ * Output:        numOfRecords - Updated to the number of records applied. May be NULL.
+ * Return Values: ALLOCATION_ERROR - In case of an allocation error, here or
+ *                in a replayed mutation.
+ *                INVALID_INPUT - If path==NULL or DS==NULL.
+ *                FAILURE - If the log can't be read completely (nothing is
+ *                applied then), can't be truncated, or a replayed mutation
+ *                failed, which means DS isn't the one the log was written against.
+ *                SUCCESS - Otherwise.
+ */
+StatusType WalReplay(const char *path, void *DS, int *numOfRecords);
+
+/* The logged versions of the library1.h mutation functions. Each returns the
+ * result of the library function, and logs the mutation only on SUCCESS.
+ * FAILURE is also returned, with the DS unchanged, if the log has failed,
+ * and, with the mutation applied but not durable, if the commit of the
+ * mutation's group fails. */
+StatusType WalAddTrainer(Wal *wal, void *DS, int trainerID);
+StatusType WalRemoveTrainer(Wal *wal, void *DS, int trainerID);
+StatusType WalCatchPokemon(Wal *wal, void *DS, int pokemonID, int trainerID,
+		int level);
+StatusType WalFreePokemon(Wal *wal, void *DS, int pokemonID);
+StatusType WalLevelUp(Wal *wal, void *DS, int pokemonID, int levelIncrease);
+StatusType WalEvolvePokemon(Wal *wal, void *DS, int pokemonID, int evolvedID);
+StatusType WalUpdateLevels(Wal *wal, void *DS, int stoneCode, int stoneFactor);
+StatusType WalTransferPokemon(Wal *wal, void *DS, int pokemonID,
+		int newTrainerID);
+StatusType WalTransferAll(Wal *wal, void *DS, int fromTrainerID,
+		int toTrainerID);
+
+#endif /* WAL_H_ */
@@ -0,0 +1,320 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : walTest.cpp                                                 */
+/*                                                                         */
+/* Tests of the write-ahead log described in wal.h: the mutations logged  */
+/* through the Wal* functions replay into an equal DS, groups reach the   */
+/* file only once committed, and WalReplay applies the intact records of  */
+/* a torn or corrupted log and cuts the log after them.                    */
+/*                                                                         */
+/* Usage: walTest                                                          */
+/*                                                                         */
+/* Built from walTest.cpp and library1.cpp with its dependencies. Prints  */
+/* every failed check and exits with 1 if any failed, 0 otherwise.        */
+/***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "wal.h"
+#include "library1.h"
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+					#condition); \
+			failures++; \
+		} \
+	} while (0)
+
+static const char *path = "walTest.wal";
+
+#define NUM_OF_RECORDS (13)
+
+/* The trainers the test log adds. */
+static const int trainerIDs[] = { 1, 2, 4 };
+static const int numOfTrainerIDs = 3;
+
+/* The size of the log file, -1 if it doesn't exist. */
+static long FileSize() {
+	struct stat fileStat;
+	if (stat(path, &fileStat) != 0) {
+		return -1;
+	}
+	return fileStat.st_size;
+}
+
+/* Writes a new log of NUM_OF_RECORDS mutations of every kind, each committed
+ * on its own, and sets offsets[i] to the offset of record i and
+ * offsets[NUM_OF_RECORDS] to the size of the log. Returns the DS the log was
+ * written from. */
+static void* WriteLog(long *offsets) {
+	unlink(path);
+	void *DS = Init();
+	Wal *wal = WalOpen(path, 1, 0);
+	CHECK(DS != NULL && wal != NULL);
+	if (DS == NULL || wal == NULL) {
+		WalClose(&wal);
+		Quit(&DS);
+		return NULL;
+	}
+	int record = 0;
+	offsets[record++] = FileSize();
+	for (int i = 0; i < numOfTrainerIDs; i++) {
+		CHECK(WalAddTrainer(wal, DS, trainerIDs[i]) == SUCCESS);
+		offsets[record++] = FileSize();
+	}
+	CHECK(WalCatchPokemon(wal, DS, 10, 1, 5) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(WalCatchPokemon(wal, DS, 11, 1, 5) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(WalCatchPokemon(wal, DS, 20, 2, 7) == SUCCESS);
+	offsets[record++] = FileSize();
+	// failed mutations aren't logged
+	CHECK(WalAddTrainer(wal, DS, 1) == FAILURE);
+	CHECK(WalCatchPokemon(wal, DS, 10, 2, 1) == FAILURE);
+	CHECK(FileSize() == offsets[record - 1]);
+	CHECK(WalLevelUp(wal, DS, 20, 4) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(WalEvolvePokemon(wal, DS, 11, 30) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(WalUpdateLevels(wal, DS, 10, 2) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(WalTransferPokemon(wal, DS, 30, 2) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(WalFreePokemon(wal, DS, 10) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(WalTransferAll(wal, DS, 2, 4) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(WalRemoveTrainer(wal, DS, 1) == SUCCESS);
+	offsets[record++] = FileSize();
+	CHECK(record == NUM_OF_RECORDS + 1);
+	WalClose(&wal);
+	CHECK(wal == NULL);
+	return DS;
+}
+
+/* Checks that two DSs hold the same pokemons in the same order, and the same
+ * trainers. */
+static void CheckSameDS(void *DS, void *other) {
+	int *pokemons = NULL;
+	int numOfPokemons = -1;
+	int *otherPokemons = NULL;
+	int numOfOther = -2;
+	CHECK(GetAllPokemonsByLevel(DS, -1, &pokemons, &numOfPokemons) == SUCCESS);
+	CHECK(GetAllPokemonsByLevel(other, -1, &otherPokemons, &numOfOther)
+			== SUCCESS);
+	CHECK(numOfOther == numOfPokemons);
+	for (int i = 0; i < numOfPokemons && i < numOfOther; i++) {
+		CHECK(otherPokemons[i] == pokemons[i]);
+	}
+	free(pokemons);
+	free(otherPokemons);
+	for (int i = 0; i < numOfTrainerIDs; i++) {
+		int count = 0, otherCount = -1;
+		long long sum = 0, otherSum = -1;
+		int max = 0, otherMax = -1;
+		StatusType res = GetTrainerStats(DS, trainerIDs[i], &count, &sum, &max);
+		CHECK(GetTrainerStats(other, trainerIDs[i], &otherCount, &otherSum,
+				&otherMax) == res);
+		if (res == SUCCESS) {
+			CHECK(count == otherCount && sum == otherSum && max == otherMax);
+		}
+	}
+}
+
+/* Replays the log into a new DS, and checks that it applied numOfRecords
+ * records and that the log was cut to size bytes. Returns the new DS. */
+static void* CheckReplay(int numOfRecords, long size) {
+	void *DS = Init();
+	int applied = -1;
+	CHECK(WalReplay(path, DS, &applied) == SUCCESS);
+	CHECK(applied == numOfRecords);
+	CHECK(FileSize() == size);
+	return DS;
+}
+
+/* Overwrites the byte at offset of the log. */
+static void Corrupt(long offset, unsigned char value) {
+	FILE *file = fopen(path, "r+b");
+	CHECK(file != NULL);
+	if (file != NULL) {
+		fseek(file, offset, SEEK_SET);
+		fputc(value, file);
+		fclose(file);
+	}
+}
+
+static void TestInvalid() {
+	void *DS = Init();
+	CHECK(WalOpen(NULL, 1, 0) == NULL);
+	CHECK(WalOpen(path, 0, 0) == NULL);
+	CHECK(WalOpen(path, 1, -1) == NULL);
+	CHECK(WalCommit(NULL) == INVALID_INPUT);
+	WalClose(NULL);
+	CHECK(WalReplay(NULL, DS, NULL) == INVALID_INPUT);
+	CHECK(WalReplay(path, NULL, NULL) == INVALID_INPUT);
+	// a missing log is an empty one
+	unlink(path);
+	int applied = -1;
+	CHECK(WalReplay(path, DS, &applied) == SUCCESS);
+	CHECK(applied == 0);
+	CHECK(FileSize() == -1);
+	Quit(&DS);
+}
+
+/* Logged mutations -> WalClose -> WalReplay into a new DS. */
+static void TestReplay() {
+	long offsets[NUM_OF_RECORDS + 1];
+	void *DS = WriteLog(offsets);
+	if (DS == NULL) {
+		return;
+	}
+	void *replayed = CheckReplay(NUM_OF_RECORDS, offsets[NUM_OF_RECORDS]);
+	CheckSameDS(DS, replayed);
+
+	// replaying into a DS the log wasn't written against fails, and keeps
+	// the log as it is
+	void *other = Init();
+	CHECK(AddTrainer(other, 2) == SUCCESS);
+	int applied = -1;
+	CHECK(WalReplay(path, other, &applied) == FAILURE);
+	CHECK(applied == 1);
+	CHECK(FileSize() == offsets[NUM_OF_RECORDS]);
+	Quit(&other);
+	Quit(&replayed);
+	Quit(&DS);
+	unlink(path);
+}
+
+/* A group reaches the file only when it's full, or on WalCommit. */
+static void TestGroupCommit() {
+	unlink(path);
+	void *DS = Init();
+	Wal *wal = WalOpen(path, 3, 0);
+	CHECK(wal != NULL);
+	if (wal == NULL) {
+		Quit(&DS);
+		return;
+	}
+	CHECK(WalAddTrainer(wal, DS, 1) == SUCCESS);
+	CHECK(WalAddTrainer(wal, DS, 2) == SUCCESS);
+	CHECK(FileSize() == 0);
+	CHECK(WalAddTrainer(wal, DS, 3) == SUCCESS);
+	long group = FileSize();
+	CHECK(group > 0);
+	CHECK(WalAddTrainer(wal, DS, 4) == SUCCESS);
+	CHECK(FileSize() == group);
+	CHECK(WalCommit(wal) == SUCCESS);
+	CHECK(FileSize() > group);
+	long committed = FileSize();
+	// nothing pending: nothing written
+	CHECK(WalCommit(wal) == SUCCESS);
+	CHECK(FileSize() == committed);
+	CHECK(WalAddTrainer(wal, DS, 5) == SUCCESS);
+	CHECK(FileSize() == committed);
+	WalClose(&wal);
+	long closed = FileSize();
+	CHECK(closed > committed);
+
+	void *replayed = CheckReplay(5, closed);
+	CheckSameDS(DS, replayed);
+	Quit(&replayed);
+	Quit(&DS);
+	unlink(path);
+}
+
+/* A torn tail is cut, and new records follow the intact ones. */
+static void TestTornTail() {
+	long offsets[NUM_OF_RECORDS + 1];
+	void *DS = WriteLog(offsets);
+	if (DS == NULL) {
+		return;
+	}
+	Quit(&DS);
+	long size = offsets[NUM_OF_RECORDS];
+
+	CHECK(truncate(path, size - 1) == 0);
+	void *replayed = CheckReplay(NUM_OF_RECORDS - 1,
+			offsets[NUM_OF_RECORDS - 1]);
+	Quit(&replayed);
+
+	// torn inside the opcode and arguments of a record, rather than its CRC
+	CHECK(truncate(path, offsets[5] + 2) == 0);
+	replayed = CheckReplay(5, offsets[5]);
+
+	Wal *wal = WalOpen(path, 1, 0);
+	CHECK(wal != NULL);
+	CHECK(WalCatchPokemon(wal, replayed, 50, 4, 1) == SUCCESS);
+	WalClose(&wal);
+	void *again = CheckReplay(6, FileSize());
+	CheckSameDS(replayed, again);
+	int top = 0;
+	CHECK(GetTopPokemon(again, 4, &top) == SUCCESS);
+	CHECK(top == 50);
+	Quit(&again);
+	Quit(&replayed);
+
+	// a single torn byte is no record at all
+	CHECK(truncate(path, 1) == 0);
+	replayed = CheckReplay(0, 0);
+	Quit(&replayed);
+	unlink(path);
+}
+
+/* Replay stops at the first record whose CRC or opcode is wrong. */
+static void TestCorrupted() {
+	long offsets[NUM_OF_RECORDS + 1];
+	void *DS = WriteLog(offsets);
+	if (DS == NULL) {
+		return;
+	}
+	Quit(&DS);
+
+	// an argument of record 4
+	Corrupt(offsets[4] + 1, 0x7f);
+	void *replayed = CheckReplay(4, offsets[4]);
+	Quit(&replayed);
+
+	DS = WriteLog(offsets);
+	Quit(&DS);
+	// the CRC of the last record
+	Corrupt(offsets[NUM_OF_RECORDS] - 1, 0);
+	Corrupt(offsets[NUM_OF_RECORDS] - 2, 0);
+	replayed = CheckReplay(NUM_OF_RECORDS - 1, offsets[NUM_OF_RECORDS - 1]);
+	Quit(&replayed);
+
+	DS = WriteLog(offsets);
+	Quit(&DS);
+	// an unknown opcode
+	Corrupt(offsets[7], 0xff);
+	replayed = CheckReplay(7, offsets[7]);
+	Quit(&replayed);
+
+	DS = WriteLog(offsets);
+	Quit(&DS);
+	// the first record
+	Corrupt(offsets[0], WAL_REMOVE_TRAINER);
+	replayed = CheckReplay(0, 0);
+	Quit(&replayed);
+	unlink(path);
+}
+
+int main() {
+	TestInvalid();
+	TestReplay();
+	TestGroupCommit();
+	TestTornTail();
+	TestCorrupted();
+	if (failures > 0) {
+		fprintf(stderr, "%d checks failed\n", failures);
+		return 1;
+	}
+	printf("walTest: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,537 @@
+/***************************************************************************/
+/*                                                                         */
+/* File Name : workloadGen.cpp                                             */
+/*                                                                         */
+/* Generates synthetic command streams for the main1 shell, as text or in  */
+/* the binary protocol of binaryProtocol.h.                                */
+/*                                                                         */
+/* Usage: workloadGen [-n commands] [-s seed] [-m mix] [-z exponent]       */
+/*                    [-T maxTrainerID] [-P maxPokemonID] [-L maxLevel]    */
+/*                    [-b]                                                 */
+/*   -n  The number of commands between Init and Quit. Default 1000000.    */
+/*   -s  The random seed; the same seed gives the same stream. Default 1.  */
+/*   -m  The relative weights of the commands, as name=weight pairs        */
+/*       separated by commas, e.g. "catch=40,free=10,all=0". Names: add,   */
+/*       catch, free, level, evolve, update, top, all. Default             */
+/*       add=2,catch=40,free=10,level=20,evolve=5,update=0.01,top=20,      */
+/*       all=1. UpdateLevels touches every pokemon, hence its small share. */
+/*   -z  The Zipf exponent of trainer and pokemon popularity. 0 picks them */
+/*       uniformly. Default 0.99.                                          */
+/*   -T  Trainer IDs are drawn from [1, maxTrainerID]. Default 1000000.    */
+/*   -P  Pokemon IDs are drawn from [1, maxPokemonID]. Default 1000000000. */
+/*   -L  Levels are drawn from [1, maxLevel]. Default 100.                 */
+/*   -b  Writes the binary protocol instead of text.                       */
+/*                                                                         */
+/* The generator tracks the trainers and pokemons it created, so commands  */
+/* refer to existing trainers and pokemons (CatchPokemon to new pokemon    */
+/* IDs, EvolvePokemon to new IDs). The popular trainers and pokemons are   */
+/* the oldest ones: the ones created first that are still there, where an  */
+/* evolved pokemon keeps the age of the one it evolved from. Queries pass  */
+/* -1 (the whole DS) a tenth of the time.                                  */
+/***************************************************************************/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+#include "binaryProtocol.h"
+#include "formatter.h"
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+#define MAX_NEW_ID_TRIES   (64)
+
+typedef enum {
+	MIX_ADD, MIX_CATCH, MIX_FREE, MIX_LEVEL, MIX_EVOLVE, MIX_UPDATE, MIX_TOP,
+	MIX_ALL, MIX_SIZE
+} MixEntry;
+
+static const char *mixNames[] = { "add", "catch", "free", "level", "evolve",
+		"update", "top", "all" };
+static const int mixOps[] = { BINARY_ADD_TRAINER, BINARY_CATCH_POKEMON,
+		BINARY_FREE_POKEMON, BINARY_LEVEL_UP, BINARY_EVOLVE_POKEMON,
+		BINARY_UPDATE_LEVELS, BINARY_GET_TOP_POKEMON,
+		BINARY_GET_ALL_POKEMONS_BY_LEVEL };
+static const char *commandStr[] = { NULL, "Init", "AddTrainer", "CatchPokemon",
+		"FreePokemon", "LevelUp", "EvolvePokemon", "GetTopPokemon",
+		"GetAllPokemonsByLevel", "UpdateLevels", "Quit" };
+
+/***************************************************************************/
+/* Random numbers                                                          */
+/***************************************************************************/
+
+/* xoshiro256** seeded through splitmix64 */
+static uint64_t randomState[4];
+
+static uint64_t SplitMix(uint64_t *seed) {
+	uint64_t z = (*seed += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static void SeedRandom(uint64_t seed) {
+	for (int i = 0; i < 4; i++) {
+		randomState[i] = SplitMix(&seed);
+	}
+}
+
+static inline uint64_t RotateLeft(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t NextRandom() {
+	uint64_t *s = randomState;
+	uint64_t result = RotateLeft(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = RotateLeft(s[3], 45);
+	return result;
+}
+
+/* A uniform double in [0, 1) */
+static double RandomUnit() {
+	return (NextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* A uniform integer in [low, high] */
+static int64_t RandomRange(int64_t low, int64_t high) {
+	return low + (int64_t) (RandomUnit() * (double) (high - low + 1));
+}
+
+/***************************************************************************/
+/* Zipf distribution                                                       */
+/***************************************************************************/
+
+/* Rank sampling from a Zipf distribution over [1, n] by rejection-inversion
+ * (Hormann and Derflinger), which takes O(1) per sample for any n, so n can
+ * follow the number of live trainers and pokemons. */
+static double zipfExponent = 0.99;
+
+static double ZipfHelper1(double x) {
+	return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - x / 4));
+}
+
+static double ZipfHelper2(double x) {
+	return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x / 2 * (1 + x / 3 * (1 + x / 4));
+}
+
+static double ZipfH(double x) {
+	return exp(-zipfExponent * log(x));
+}
+
+static double ZipfHIntegral(double x) {
+	double logX = log(x);
+	return ZipfHelper2((1 - zipfExponent) * logX) * logX;
+}
+
+static double ZipfHIntegralInverse(double x) {
+	double t = x * (1 - zipfExponent);
+	if (t < -1) {
+		t = -1;
+	}
+	return exp(ZipfHelper1(t) * x);
+}
+
+static int64_t ZipfRank(int64_t n) {
+	double hIntegralX1 = ZipfHIntegral(1.5) - 1;
+	double hIntegralN = ZipfHIntegral(n + 0.5);
+	double s = 2 - ZipfHIntegralInverse(ZipfHIntegral(2.5) - ZipfH(2));
+	for (;;) {
+		double u = hIntegralN + RandomUnit() * (hIntegralX1 - hIntegralN);
+		double x = ZipfHIntegralInverse(u);
+		int64_t k = (int64_t) (x + 0.5);
+		if (k < 1) {
+			k = 1;
+		} else if (k > n) {
+			k = n;
+		}
+		if (k - x <= s || u >= ZipfHIntegral(k + 0.5) - ZipfH(k)) {
+			return k;
+		}
+	}
+}
+
+/***************************************************************************/
+/* Live IDs                                                                */
+/***************************************************************************/
+
+/* The IDs in use, in creation order so that Zipf ranks favor the oldest.
+ * Every ID gets a slot when it is added; removing it only marks its slot
+ * dead, so the others keep their order. A Fenwick tree over the slots counts
+ * the live ones, so the ID of a given rank is found in O(log n), and the
+ * dead slots are dropped once they outnumber the live ones. */
+typedef struct {
+	std::vector<int> ids;
+	std::vector<char> alive;
+	// tree[i] counts the live slots in (i - lowbit(i), i], 1-based
+	std::vector<int> tree;
+	std::unordered_map<int, size_t> positions;
+	size_t numOfLive;
+} LiveIds;
+
+static inline size_t LowBit(size_t i) {
+	return i & (0 - i);
+}
+
+static bool LiveEmpty(const LiveIds *live) {
+	return live->numOfLive == 0;
+}
+
+static bool LiveContains(const LiveIds *live, int id) {
+	return live->positions.count(id) != 0;
+}
+
+/* Rebuilds the slots from the live IDs, in the same order, in O(n) */
+static void LiveCompact(LiveIds *live) {
+	size_t next = 0;
+	for (size_t slot = 0; slot < live->ids.size(); slot++) {
+		if (live->alive[slot]) {
+			live->ids[next] = live->ids[slot];
+			live->positions[live->ids[next]] = next;
+			next++;
+		}
+	}
+	live->ids.resize(next);
+	live->alive.assign(next, 1);
+	live->tree.assign(next + 1, 0);
+	for (size_t i = 1; i <= next; i++) {
+		live->tree[i]++;
+		if (i + LowBit(i) <= next) {
+			live->tree[i + LowBit(i)] += live->tree[i];
+		}
+	}
+}
+
+static void LiveAdd(LiveIds *live, int id) {
+	if (live->tree.empty()) {
+		live->tree.push_back(0);
+	}
+	live->positions[id] = live->ids.size();
+	live->ids.push_back(id);
+	live->alive.push_back(1);
+	// the new node covers itself and the nodes of its lower bits
+	size_t i = live->ids.size();
+	int count = 1;
+	for (size_t j = i - 1; j > i - LowBit(i); j -= LowBit(j)) {
+		count += live->tree[j];
+	}
+	live->tree.push_back(count);
+	live->numOfLive++;
+}
+
+static void LiveRemove(LiveIds *live, int id) {
+	size_t slot = live->positions[id];
+	live->positions.erase(id);
+	live->alive[slot] = 0;
+	for (size_t i = slot + 1; i < live->tree.size(); i += LowBit(i)) {
+		live->tree[i]--;
+	}
+	live->numOfLive--;
+	if (live->ids.size() > 2 * live->numOfLive + 1024) {
+		LiveCompact(live);
+	}
+}
+
+/* Gives newID the slot, and so the age, of id */
+static void LiveReplace(LiveIds *live, int id, int newID) {
+	size_t slot = live->positions[id];
+	live->positions.erase(id);
+	live->positions[newID] = slot;
+	live->ids[slot] = newID;
+}
+
+static int LivePick(const LiveIds *live) {
+	int rank = (int) ZipfRank((int64_t) live->numOfLive);
+	// descend the tree to the slot holding the rank-th live ID
+	size_t size = live->ids.size();
+	size_t step = 1;
+	while (2 * step <= size) {
+		step *= 2;
+	}
+	size_t position = 0;
+	for (; step > 0; step /= 2) {
+		if (position + step <= size && live->tree[position + step] < rank) {
+			position += step;
+			rank -= live->tree[position];
+		}
+	}
+	return live->ids[position];
+}
+
+/* A random ID in [1, maxID] not in use, or 0 if none was found */
+static int NewId(const LiveIds *live, int maxID) {
+	for (int i = 0; i < MAX_NEW_ID_TRIES; i++) {
+		int id = (int) RandomRange(1, maxID);
+		if (!LiveContains(live, id)) {
+			return id;
+		}
+	}
+	return 0;
+}
+
+/***************************************************************************/
+/* Output                                                                  */
+/***************************************************************************/
+
+static bool binaryOutput = false;
+static char outputBuffer[OUTPUT_BUFFER_SIZE];
+static size_t outputUsed = 0;
+
+static void FlushOutput() {
+	fwrite(outputBuffer, 1, outputUsed, stdout);
+	outputUsed = 0;
+}
+
+static void WriteCommand(int op, const int *args) {
+	int numOfArgs = BinaryOpArgs(op);
+	// the longest command: a name, three ints, separators and '\n'
+	if (outputUsed + 64 + 3 * FORMAT_INT_MAX_LENGTH > OUTPUT_BUFFER_SIZE) {
+		FlushOutput();
+	}
+	char *end = outputBuffer + outputUsed;
+	if (binaryOutput) {
+		*end++ = (char) op;
+		for (int i = 0; i < numOfArgs; i++) {
+			int32_t value = args[i];
+			memcpy(end, &value, sizeof(value));
+			end += sizeof(value);
+		}
+	} else {
+		size_t nameLength = strlen(commandStr[op]);
+		memcpy(end, commandStr[op], nameLength);
+		end += nameLength;
+		for (int i = 0; i < numOfArgs; i++) {
+			*end++ = ' ';
+			end += FormatInt(end, args[i]);
+		}
+		*end++ = '\n';
+	}
+	outputUsed = end - outputBuffer;
+}
+
+/***************************************************************************/
+/* Generator                                                               */
+/***************************************************************************/
+
+typedef struct {
+	long long numOfCommands;
+	uint64_t seed;
+	double mix[MIX_SIZE];
+	int maxTrainerID;
+	int maxPokemonID;
+	int maxLevel;
+} Options;
+
+static bool ParseMix(const char *str, double *mix) {
+	for (int entry = 0; entry < MIX_SIZE; entry++) {
+		mix[entry] = 0;
+	}
+	while (*str != '\0') {
+		const char *equals = strchr(str, '=');
+		if (equals == NULL) {
+			return false;
+		}
+		int entry = 0;
+		while (entry < MIX_SIZE
+				&& (strlen(mixNames[entry]) != (size_t) (equals - str)
+						|| strncmp(mixNames[entry], str, equals - str) != 0)) {
+			entry++;
+		}
+		char *end;
+		double weight = strtod(equals + 1, &end);
+		if (entry == MIX_SIZE || end == equals + 1 || weight < 0
+				|| (*end != ',' && *end != '\0')) {
+			return false;
+		}
+		mix[entry] = weight;
+		str = (*end == ',') ? end + 1 : end;
+	}
+	return true;
+}
+
+static MixEntry PickEntry(const double *mix, double totalWeight) {
+	double x = RandomUnit() * totalWeight;
+	for (int entry = 0; entry < MIX_SIZE - 1; entry++) {
+		if (x < mix[entry]) {
+			return (MixEntry) entry;
+		}
+		x -= mix[entry];
+	}
+	return (MixEntry) (MIX_SIZE - 1);
+}
+
+/* The trainer argument of a query: -1 for the whole DS a tenth of the time */
+static int QueryTrainer(const LiveIds *trainers) {
+	if (LiveEmpty(trainers) || RandomRange(0, 9) == 0) {
+		return -1;
+	}
+	return LivePick(trainers);
+}
+
+static void Generate(const Options *options) {
+	LiveIds trainers;
+	LiveIds pokemons;
+	trainers.numOfLive = 0;
+	pokemons.numOfLive = 0;
+	double totalWeight = 0;
+	for (int entry = 0; entry < MIX_SIZE; entry++) {
+		totalWeight += options->mix[entry];
+	}
+
+	WriteCommand(BINARY_INIT, NULL);
+	for (long long i = 0; i < options->numOfCommands; i++) {
+		MixEntry entry = PickEntry(options->mix, totalWeight);
+		// a command on pokemons needs one, a catch needs a trainer
+		if ((entry == MIX_FREE || entry == MIX_LEVEL || entry == MIX_EVOLVE)
+				&& LiveEmpty(&pokemons)) {
+			entry = MIX_CATCH;
+		}
+		if (entry == MIX_CATCH && LiveEmpty(&trainers)) {
+			entry = MIX_ADD;
+		}
+
+		int args[BINARY_MAX_ARGS];
+		switch (entry) {
+		case MIX_ADD:
+			args[0] = NewId(&trainers, options->maxTrainerID);
+			if (args[0] == 0) {
+				args[0] = LivePick(&trainers); // fails, the IDs ran out
+			} else {
+				LiveAdd(&trainers, args[0]);
+			}
+			break;
+		case MIX_CATCH:
+			args[0] = NewId(&pokemons, options->maxPokemonID);
+			if (args[0] == 0) {
+				args[0] = LivePick(&pokemons);
+			} else {
+				LiveAdd(&pokemons, args[0]);
+			}
+			args[1] = LivePick(&trainers);
+			args[2] = (int) RandomRange(1, options->maxLevel);
+			break;
+		case MIX_FREE:
+			args[0] = LivePick(&pokemons);
+			LiveRemove(&pokemons, args[0]);
+			break;
+		case MIX_LEVEL:
+			args[0] = LivePick(&pokemons);
+			args[1] = (int) RandomRange(1, 10);
+			break;
+		case MIX_EVOLVE:
+			args[0] = LivePick(&pokemons);
+			args[1] = NewId(&pokemons, options->maxPokemonID);
+			if (args[1] == 0) {
+				args[1] = LivePick(&pokemons);
+			} else {
+				LiveReplace(&pokemons, args[0], args[1]);
+			}
+			break;
+		case MIX_UPDATE:
+			args[0] = (int) RandomRange(2, 100);
+			args[1] = (int) RandomRange(1, 3);
+			break;
+		case MIX_TOP:
+		case MIX_ALL:
+			args[0] = QueryTrainer(&trainers);
+			break;
+		default:
+			break;
+		}
+		WriteCommand(mixOps[entry], args);
+	}
+	WriteCommand(BINARY_QUIT, NULL);
+	FlushOutput();
+}
+
+static void Usage(const char *name) {
+	fprintf(stderr, "usage: %s [-n commands] [-s seed] [-m mix] "
+			"[-z exponent] [-T maxTrainerID] [-P maxPokemonID] "
+			"[-L maxLevel] [-b]\n", name);
+}
+
+int main(int argc, const char**argv) {
+	Options options;
+	options.numOfCommands = 1000000;
+	options.seed = 1;
+	ParseMix("add=2,catch=40,free=10,level=20,evolve=5,update=0.01,top=20,"
+			"all=1", options.mix);
+	options.maxTrainerID = 1000000;
+	options.maxPokemonID = 1000000000;
+	options.maxLevel = 100;
+
+	for (int i = 1; i < argc; i++) {
+		const char *option = argv[i];
+		if (strcmp(option, "-b") == 0) {
+			binaryOutput = true;
+			continue;
+		}
+		if (i + 1 == argc || option[0] != '-' || strlen(option) != 2) {
+			Usage(argv[0]);
+			return 1;
+		}
+		const char *value = argv[++i];
+		bool ok = true;
+		switch (option[1]) {
+		case 'n':
+			options.numOfCommands = atoll(value);
+			ok = options.numOfCommands >= 0;
+			break;
+		case 's':
+			options.seed = strtoull(value, NULL, 10);
+			break;
+		case 'm':
+			ok = ParseMix(value, options.mix);
+			break;
+		case 'z':
+			zipfExponent = atof(value);
+			ok = zipfExponent >= 0;
+			break;
+		case 'T':
+			options.maxTrainerID = atoi(value);
+			ok = options.maxTrainerID > 0;
+			break;
+		case 'P':
+			options.maxPokemonID = atoi(value);
+			ok = options.maxPokemonID > 0;
+			break;
+		case 'L':
+			options.maxLevel = atoi(value);
+			ok = options.maxLevel > 0;
+			break;
+		default:
+			ok = false;
+			break;
+		}
+		if (!ok) {
+			Usage(argv[0]);
+			return 1;
+		}
+	}
+	double totalWeight = 0;
+	for (int entry = 0; entry < MIX_SIZE; entry++) {
+		totalWeight += options.mix[entry];
+	}
+	if (totalWeight <= 0) {
+		fprintf(stderr, "the mix has no weight\n");
+		return 1;
+	}
+
+	SeedRandom(options.seed);
+	if (binaryOutput) {
+		fwrite(BINARY_MAGIC, BINARY_MAGIC_SIZE, 1, stdout);
+	}
+	Generate(&options);
+	if (fflush(stdout) != 0 || ferror(stdout)) {
+		perror("stdout");
+		return 1;
+	}
+	return 0;
+}